@@ -0,0 +1,236 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <array>
+#include <atomic>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#endif
+
+namespace detail
+{
+
+// Hint to the CPU that the thread is spinning
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+
+}
+
+// basic_inplace_string shared between threads, e.g. a status published by a feed thread and read by many strategy
+// threads. Strings of up to 8 bytes (inplace_string<7>) are stored in a single std::atomic<std::uint64_t>: all the
+// operations are lock-free and load() is wait-free. Longer strings are stored in 64-bit atomic words behind a sequence
+// lock: load() never blocks the writers and retries only while a write is in progress, and writers (store, exchange,
+// compare_exchange) take the sequence lock in turn.
+template <
+	std::size_t N,
+	typename CharT = char,
+	typename Traits = std::char_traits<CharT>>
+class basic_atomic_inplace_string
+{
+public:
+	using value_type = basic_inplace_string<N, CharT, Traits>;
+
+	static constexpr std::size_t word_count = (sizeof(value_type) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+	static constexpr bool is_always_lock_free = word_count == 1 && std::atomic<std::uint64_t>::is_always_lock_free;
+
+	basic_atomic_inplace_string() noexcept : basic_atomic_inplace_string(value_type{}) {}
+	explicit basic_atomic_inplace_string(const value_type& str) noexcept;
+
+	basic_atomic_inplace_string(const basic_atomic_inplace_string&) = delete;
+	basic_atomic_inplace_string& operator=(const basic_atomic_inplace_string&) = delete;
+
+	value_type load() const noexcept;
+	void store(const value_type& str) noexcept;
+	value_type exchange(const value_type& str) noexcept;
+
+	// Replaces the string with desired if it is equal to expected, otherwise loads it into expected
+	bool compare_exchange(value_type& expected, const value_type& desired) noexcept;
+
+	operator value_type() const noexcept { return load(); }
+	basic_atomic_inplace_string& operator=(const value_type& str) noexcept { store(str); return *this; }
+
+private:
+	using words_type = std::array<std::uint64_t, word_count>;
+
+	static words_type to_words(const value_type& str) noexcept
+	{
+		// the characters past the terminator are zero: equal strings have equal words
+		words_type words{};
+		std::memcpy(words.data(), &str, sizeof(value_type));
+		return words;
+	}
+
+	static value_type from_words(const words_type& words) noexcept
+	{
+		value_type str;
+		std::memcpy(static_cast<void*>(&str), words.data(), sizeof(value_type));
+		return str;
+	}
+
+	words_type load_words() const noexcept;
+
+	// Sequence lock of the writers, returns the (even) sequence before the write
+	std::uint64_t lock() noexcept;
+	void write_and_unlock(std::uint64_t sequence, const words_type& words) noexcept;
+
+	std::atomic<std::uint64_t> _sequence{0}; // odd while a write is in progress, unused for a single word
+	std::array<std::atomic<std::uint64_t>, word_count> _words;
+};
+
+template <std::size_t N, typename CharT, typename Traits>
+basic_atomic_inplace_string<N, CharT, Traits>::basic_atomic_inplace_string(const value_type& str) noexcept
+{
+	const words_type words = to_words(str);
+	for (std::size_t i = 0; i < word_count; ++i)
+		_words[i].store(words[i], std::memory_order_relaxed);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_atomic_inplace_string<N, CharT, Traits>::words_type
+basic_atomic_inplace_string<N, CharT, Traits>::load_words() const noexcept
+{
+	words_type words;
+
+	if constexpr (word_count == 1)
+	{
+		words[0] = _words[0].load(std::memory_order_acquire);
+	}
+	else
+	{
+		for (;;)
+		{
+			const std::uint64_t sequence = _sequence.load(std::memory_order_acquire);
+			if (sequence & 1)
+			{
+				detail::cpu_relax();
+				continue;
+			}
+
+			for (std::size_t i = 0; i < word_count; ++i)
+				words[i] = _words[i].load(std::memory_order_relaxed);
+
+			// the words must be read before the sequence is checked again
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (_sequence.load(std::memory_order_relaxed) == sequence)
+				break;
+		}
+	}
+
+	return words;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+std::uint64_t basic_atomic_inplace_string<N, CharT, Traits>::lock() noexcept
+{
+	std::uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		if ((sequence & 1) == 0 && _sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			break;
+
+		detail::cpu_relax();
+		sequence = _sequence.load(std::memory_order_relaxed);
+	}
+
+	// the odd sequence must be visible before any of the words is written
+	std::atomic_thread_fence(std::memory_order_release);
+	return sequence;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_atomic_inplace_string<N, CharT, Traits>::write_and_unlock(std::uint64_t sequence, const words_type& words) noexcept
+{
+	for (std::size_t i = 0; i < word_count; ++i)
+		_words[i].store(words[i], std::memory_order_relaxed);
+
+	_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_atomic_inplace_string<N, CharT, Traits>::value_type
+basic_atomic_inplace_string<N, CharT, Traits>::load() const noexcept
+{
+	return from_words(load_words());
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_atomic_inplace_string<N, CharT, Traits>::store(const value_type& str) noexcept
+{
+	const words_type words = to_words(str);
+
+	if constexpr (word_count == 1)
+	{
+		_words[0].store(words[0], std::memory_order_release);
+	}
+	else
+	{
+		write_and_unlock(lock(), words);
+	}
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_atomic_inplace_string<N, CharT, Traits>::value_type
+basic_atomic_inplace_string<N, CharT, Traits>::exchange(const value_type& str) noexcept
+{
+	const words_type words = to_words(str);
+	words_type previous;
+
+	if constexpr (word_count == 1)
+	{
+		previous[0] = _words[0].exchange(words[0], std::memory_order_acq_rel);
+	}
+	else
+	{
+		const std::uint64_t sequence = lock();
+		for (std::size_t i = 0; i < word_count; ++i)
+			previous[i] = _words[i].load(std::memory_order_relaxed);
+		write_and_unlock(sequence, words);
+	}
+
+	return from_words(previous);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+bool basic_atomic_inplace_string<N, CharT, Traits>::compare_exchange(value_type& expected, const value_type& desired) noexcept
+{
+	words_type current = to_words(expected);
+	const words_type words = to_words(desired);
+	bool exchanged;
+
+	if constexpr (word_count == 1)
+	{
+		exchanged = _words[0].compare_exchange_strong(current[0], words[0], std::memory_order_acq_rel, std::memory_order_acquire);
+	}
+	else
+	{
+		const std::uint64_t sequence = lock();
+
+		words_type actual;
+		for (std::size_t i = 0; i < word_count; ++i)
+			actual[i] = _words[i].load(std::memory_order_relaxed);
+
+		exchanged = actual == current;
+		if (exchanged)
+			write_and_unlock(sequence, words);
+		else
+			_sequence.store(sequence, std::memory_order_release); // unchanged: the readers need not retry
+
+		current = actual;
+	}
+
+	if (!exchanged)
+		expected = from_words(current);
+	return exchanged;
+}
+
+template <std::size_t N> using atomic_inplace_string = basic_atomic_inplace_string<N, char>;
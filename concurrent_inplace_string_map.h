@@ -0,0 +1,326 @@
+#pragma once
+
+#include "atomic_inplace_string.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// Hash map from basic_inplace_string to trivially copyable values, read concurrently without locks and updated rarely.
+// Keys and values are stored inline in an open-addressing table of fixed capacity, each slot protected by its own
+// sequence lock: readers copy a slot and retry only if a writer modified it meanwhile. Writers are serialized per
+// stripe of keys (by hash), so that updates of unrelated keys proceed in parallel. Erased slots are kept as tombstones
+// and reused by later insertions.
+template <
+	std::size_t N,
+	typename T,
+	typename CharT = char,
+	typename Traits = std::char_traits<CharT>,
+	typename Hash = std::hash<basic_inplace_string<N, CharT, Traits>>>
+class concurrent_inplace_string_map
+{
+public:
+	static_assert(std::is_trivially_copyable<T>::value, "concurrent_inplace_string_map: values must be trivially copyable");
+
+	using key_type = basic_inplace_string<N, CharT, Traits>;
+	using mapped_type = T;
+	using size_type = std::size_t;
+	using view_type = basic_string_view<CharT, Traits>;
+	using hasher = Hash;
+
+	static constexpr size_type stripe_count = 64;
+
+	// Holds up to capacity keys, including the erased ones whose slot has not been reused
+	explicit concurrent_inplace_string_map(size_type capacity, const Hash& hash = Hash());
+
+	concurrent_inplace_string_map(const concurrent_inplace_string_map&) = delete;
+	concurrent_inplace_string_map& operator=(const concurrent_inplace_string_map&) = delete;
+
+	size_type size() const noexcept     { return _size.load(std::memory_order_relaxed); }
+	bool empty() const noexcept         { return size() == 0; }
+	size_type capacity() const noexcept { return _capacity; }
+
+	// Copies the value of key into value, false if not found. Lock-free.
+	bool find(view_type key, T& value) const;
+	bool contains(view_type key) const;
+
+	// Inserts key if not present, returns false otherwise. Throws std::length_error when the map is full.
+	bool insert(const key_type& key, const T& value);
+	void insert_or_assign(const key_type& key, const T& value);
+
+	bool erase(view_type key);
+
+private:
+	enum slot_state : std::uint32_t
+	{
+		empty_slot = 0,
+		occupied_slot = 1,
+		erased_slot = 2
+	};
+
+	static constexpr size_type key_words = (sizeof(key_type) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+	static constexpr size_type value_words = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+	using key_words_type = std::array<std::uint64_t, key_words>;
+	using value_words_type = std::array<std::uint64_t, value_words>;
+
+	struct slot
+	{
+		std::atomic<std::uint32_t> version;  // odd while a writer holds the slot
+		std::atomic<std::uint32_t> state;
+		std::array<std::atomic<std::uint64_t>, key_words> key;
+		std::array<std::atomic<std::uint64_t>, value_words> value;
+	};
+
+	struct snapshot
+	{
+		std::uint32_t state;
+		key_words_type key;
+		value_words_type value;
+	};
+
+	template <typename Words, typename U>
+	static Words to_words(const U& u) noexcept
+	{
+		Words words{};
+		std::memcpy(words.data(), &u, sizeof(U));
+		return words;
+	}
+
+	// Consistent copy of a slot
+	snapshot read(const slot& s) const noexcept;
+
+	// Locks the slot, returns its (even) version
+	static std::uint32_t lock(slot& s) noexcept;
+	static void unlock(slot& s, std::uint32_t version) noexcept { s.version.store(version + 2, std::memory_order_release); }
+
+	static void store(slot& s, std::uint32_t state, const key_words_type& key, const value_words_type& value) noexcept;
+
+	// Slot of key, _slot_count if not found
+	size_type find_slot(const key_words_type& key, std::size_t h) const noexcept;
+
+	// Inserts or assigns under the stripe lock of key
+	bool insert(const key_type& key, const T& value, bool assign);
+
+	std::unique_ptr<slot[]> _slots;
+	size_type _slot_count;
+	size_type _capacity;
+	Hash _hash;
+
+	std::atomic<size_type> _size{0};
+	std::atomic<size_type> _used{0}; // occupied and erased slots
+	std::mutex _stripes[stripe_count];
+};
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::concurrent_inplace_string_map(size_type capacity, const Hash& hash) :
+	_capacity(capacity),
+	_hash(hash)
+{
+	// at most half of the slots are used
+	_slot_count = 2;
+	while (_slot_count < 2 * capacity)
+		_slot_count *= 2;
+
+	// value-initialized: all the slots are empty
+	_slots.reset(new slot[_slot_count]());
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+typename concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::snapshot
+concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::read(const slot& s) const noexcept
+{
+	snapshot snap;
+	for (;;)
+	{
+		const std::uint32_t version = s.version.load(std::memory_order_acquire);
+		if (version & 1)
+		{
+			detail::cpu_relax();
+			continue;
+		}
+
+		snap.state = s.state.load(std::memory_order_relaxed);
+		for (size_type i = 0; i < key_words; ++i)
+			snap.key[i] = s.key[i].load(std::memory_order_relaxed);
+		for (size_type i = 0; i < value_words; ++i)
+			snap.value[i] = s.value[i].load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (s.version.load(std::memory_order_relaxed) == version)
+			return snap;
+	}
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+std::uint32_t concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::lock(slot& s) noexcept
+{
+	std::uint32_t version = s.version.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		if ((version & 1) == 0 && s.version.compare_exchange_weak(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			break;
+
+		detail::cpu_relax();
+		version = s.version.load(std::memory_order_relaxed);
+	}
+
+	std::atomic_thread_fence(std::memory_order_release);
+	return version;
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+void concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::store(slot& s, std::uint32_t state, const key_words_type& key,
+																	 const value_words_type& value) noexcept
+{
+	s.state.store(state, std::memory_order_relaxed);
+	for (size_type i = 0; i < key_words; ++i)
+		s.key[i].store(key[i], std::memory_order_relaxed);
+	for (size_type i = 0; i < value_words; ++i)
+		s.value[i].store(value[i], std::memory_order_relaxed);
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+typename concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::size_type
+concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::find_slot(const key_words_type& key, std::size_t h) const noexcept
+{
+	const size_type mask = _slot_count - 1;
+
+	for (size_type i = h & mask, probes = 0; probes < _slot_count; i = (i + 1) & mask, ++probes)
+	{
+		const snapshot snap = read(_slots[i]);
+		if (snap.state == empty_slot)
+			break;
+		if (snap.state == occupied_slot && snap.key == key)
+			return i;
+	}
+	return _slot_count;
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+bool concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::find(view_type key, T& value) const
+{
+	if (key.size() > N)
+		return false;
+
+	const key_type k(key);
+	const key_words_type words = to_words<key_words_type>(k);
+	const size_type mask = _slot_count - 1;
+
+	for (size_type i = _hash(k) & mask, probes = 0; probes < _slot_count; i = (i + 1) & mask, ++probes)
+	{
+		const snapshot snap = read(_slots[i]);
+		if (snap.state == empty_slot)
+			return false;
+
+		if (snap.state == occupied_slot && snap.key == words)
+		{
+			std::memcpy(static_cast<void*>(&value), snap.value.data(), sizeof(T));
+			return true;
+		}
+	}
+	return false;
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+bool concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::contains(view_type key) const
+{
+	if (key.size() > N)
+		return false;
+
+	const key_type k(key);
+	return find_slot(to_words<key_words_type>(k), _hash(k)) != _slot_count;
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+bool concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::insert(const key_type& key, const T& value)
+{
+	return insert(key, value, false);
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+void concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::insert_or_assign(const key_type& key, const T& value)
+{
+	insert(key, value, true);
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+bool concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::insert(const key_type& key, const T& value, bool assign)
+{
+	const std::size_t h = _hash(key);
+	const key_words_type key_w = to_words<key_words_type>(key);
+	const value_words_type value_w = to_words<value_words_type>(value);
+	const size_type mask = _slot_count - 1;
+
+	// the key can only be inserted or erased by the holder of its stripe
+	std::lock_guard<std::mutex> guard(_stripes[(h >> 16) % stripe_count]);
+
+	const size_type found = find_slot(key_w, h);
+	if (found != _slot_count)
+	{
+		if (assign)
+		{
+			slot& s = _slots[found];
+			const std::uint32_t version = lock(s);
+			store(s, occupied_slot, key_w, value_w);
+			unlock(s, version);
+		}
+		return false;
+	}
+
+	// first empty or erased slot, which writers of other stripes may take first
+	for (size_type i = h & mask, probes = 0; probes < _slot_count; i = (i + 1) & mask, ++probes)
+	{
+		slot& s = _slots[i];
+		if (s.state.load(std::memory_order_relaxed) == occupied_slot)
+			continue;
+
+		const std::uint32_t version = lock(s);
+		const std::uint32_t state = s.state.load(std::memory_order_relaxed);
+
+		if (state == empty_slot && _used.fetch_add(1, std::memory_order_relaxed) >= _capacity)
+		{
+			_used.fetch_sub(1, std::memory_order_relaxed);
+			s.version.store(version, std::memory_order_release);
+			detail::throw_helper<std::length_error>("concurrent_inplace_string_map: exceed capacity");
+		}
+
+		if (state != occupied_slot)
+		{
+			store(s, occupied_slot, key_w, value_w);
+			unlock(s, version);
+			_size.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		s.version.store(version, std::memory_order_release);
+	}
+
+	detail::throw_helper<std::length_error>("concurrent_inplace_string_map: exceed capacity");
+	return false;
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits, typename Hash>
+bool concurrent_inplace_string_map<N, T, CharT, Traits, Hash>::erase(view_type key)
+{
+	if (key.size() > N)
+		return false;
+
+	const key_type k(key);
+	const std::size_t h = _hash(k);
+	const key_words_type key_w = to_words<key_words_type>(k);
+
+	std::lock_guard<std::mutex> guard(_stripes[(h >> 16) % stripe_count]);
+
+	const size_type found = find_slot(key_w, h);
+	if (found == _slot_count)
+		return false;
+
+	slot& s = _slots[found];
+	const std::uint32_t version = lock(s);
+	store(s, erased_slot, key_words_type{}, value_words_type{});
+	unlock(s, version);
+
+	_size.fetch_sub(1, std::memory_order_relaxed);
+	return true;
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "inplace_string.h"
+#include "inplace_string_algorithm.h"
+
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+
+// Dictionary-encoded column of inplace_string<N>: each distinct string is stored once, and each row holds the 8, 16 or
+// 32-bit code of its string. Predicates are evaluated once per distinct string, and then applied to the codes of the
+// rows to fill a bitmap of 64-row words.
+template <std::size_t N, typename Code = std::uint32_t>
+class dictionary_column
+{
+public:
+	static_assert(std::is_same<Code, std::uint8_t>::value || std::is_same<Code, std::uint16_t>::value || std::is_same<Code, std::uint32_t>::value,
+				  "dictionary_column: codes must be 8, 16 or 32-bit unsigned integers");
+
+	using string_type = inplace_string<N>;
+	using value_type = string_type;
+	using code_type = Code;
+	using size_type = std::size_t;
+	using view_type = basic_string_view<char, std::char_traits<char>>;
+
+	dictionary_column() = default;
+
+	template <typename InputIt, typename X = typename std::enable_if<detail::is_input_iterator<InputIt>::value>::type>
+	dictionary_column(InputIt first, InputIt last);
+
+	dictionary_column(std::initializer_list<view_type> ilist) : dictionary_column(ilist.begin(), ilist.end()) {}
+
+	const string_type& operator[](size_type i) const noexcept { assert(i < size()); return _dictionary[_codes[i]]; }
+	const string_type& at(size_type i) const;
+
+	size_type size() const noexcept { return _codes.size(); }
+	bool empty() const noexcept     { return _codes.empty(); }
+
+	// Distinct strings, indexed by their code
+	const std::vector<string_type>& dictionary() const noexcept { return _dictionary; }
+	const std::vector<code_type>& codes() const noexcept        { return _codes; }
+
+	void reserve(size_type new_cap) { _codes.reserve(new_cap); }
+
+	// Appends a row, adds sv to the dictionary if required and returns its code
+	code_type push_back(view_type sv);
+
+	// Code of sv, false if sv is not in the dictionary
+	bool find_code(view_type sv, code_type& code) const;
+
+	// Number of 64-bit words of the bitmap of a column of rows rows
+	static size_type bitmap_size(size_type rows) noexcept { return (rows + 63) / 64; }
+
+	// The following set bit i of bitmap iff row i satisfies the predicate. The bitmap must hold bitmap_size(size())
+	// words; the bits past the last row are cleared.
+	template <typename Pred>
+	void select(Pred pred, std::uint64_t* bitmap) const;
+
+	void select_equal(view_type sv, std::uint64_t* bitmap) const;
+	void select_starts_with(view_type prefix, std::uint64_t* bitmap) const;
+	void select_contains(view_type sv, std::uint64_t* bitmap) const;
+
+	// lo <= row < hi
+	void select_range(view_type lo, view_type hi, std::uint64_t* bitmap) const;
+
+private:
+	// Fills the bitmap from flag(code), evaluated for 64 rows at a time
+	template <typename Flag>
+	void fill_bitmap(Flag flag, std::uint64_t* bitmap) const;
+
+	std::vector<string_type> _dictionary;
+	std::unordered_map<string_type, code_type> _index;
+	std::vector<code_type> _codes;
+};
+
+template <std::size_t N, typename Code>
+template <typename InputIt, typename X>
+dictionary_column<N, Code>::dictionary_column(InputIt first, InputIt last)
+{
+	for (; first != last; ++first)
+		push_back(view_type(*first));
+}
+
+template <std::size_t N, typename Code>
+const typename dictionary_column<N, Code>::string_type& dictionary_column<N, Code>::at(size_type i) const
+{
+	if (i >= size())
+		detail::throw_helper<std::out_of_range>("dictionary_column::at: out of range");
+
+	return (*this)[i];
+}
+
+template <std::size_t N, typename Code>
+typename dictionary_column<N, Code>::code_type dictionary_column<N, Code>::push_back(view_type sv)
+{
+	const string_type str(sv);
+
+	auto it = _index.find(str);
+	if (it == _index.end())
+	{
+		if (_dictionary.size() > std::numeric_limits<code_type>::max())
+			detail::throw_helper<std::length_error>("dictionary_column: too many distinct strings for the code type");
+
+		it = _index.emplace(str, static_cast<code_type>(_dictionary.size())).first;
+		_dictionary.push_back(str);
+	}
+
+	_codes.push_back(it->second);
+	return it->second;
+}
+
+template <std::size_t N, typename Code>
+bool dictionary_column<N, Code>::find_code(view_type sv, code_type& code) const
+{
+	if (sv.size() > N)
+		return false;
+
+	const auto it = _index.find(string_type(sv));
+	if (it == _index.end())
+		return false;
+
+	code = it->second;
+	return true;
+}
+
+template <std::size_t N, typename Code>
+template <typename Flag>
+void dictionary_column<N, Code>::fill_bitmap(Flag flag, std::uint64_t* bitmap) const
+{
+	const code_type* codes = _codes.data();
+	const size_type count = _codes.size();
+
+	// the flags of 64 rows are computed in a loop the compiler can vectorize, then packed into a word
+	alignas(64) std::uint8_t flags[64];
+
+	size_type i = 0;
+	for (; i + 64 <= count; i += 64)
+	{
+		for (size_type j = 0; j < 64; ++j)
+			flags[j] = flag(codes[i + j]);
+		*bitmap++ = detail::pack_bits(flags);
+	}
+
+	if (i < count)
+	{
+		for (size_type j = 0; j < 64; ++j)
+			flags[j] = i + j < count ? flag(codes[i + j]) : std::uint8_t{0};
+		*bitmap = detail::pack_bits(flags);
+	}
+}
+
+template <std::size_t N, typename Code>
+template <typename Pred>
+void dictionary_column<N, Code>::select(Pred pred, std::uint64_t* bitmap) const
+{
+	std::vector<std::uint8_t> selected(_dictionary.size());
+	for (size_type c = 0; c < _dictionary.size(); ++c)
+		selected[c] = static_cast<std::uint8_t>(pred(_dictionary[c]));
+
+	const std::uint8_t* s = selected.data();
+	fill_bitmap([s](code_type c) { return s[c]; }, bitmap);
+}
+
+template <std::size_t N, typename Code>
+void dictionary_column<N, Code>::select_equal(view_type sv, std::uint64_t* bitmap) const
+{
+	code_type code;
+	if (!find_code(sv, code))
+	{
+		std::fill(bitmap, bitmap + bitmap_size(size()), std::uint64_t{0});
+		return;
+	}
+
+	// a single code: the rows are compared with it directly
+	fill_bitmap([code](code_type c) { return static_cast<std::uint8_t>(c == code); }, bitmap);
+}
+
+template <std::size_t N, typename Code>
+void dictionary_column<N, Code>::select_starts_with(view_type prefix, std::uint64_t* bitmap) const
+{
+	select([prefix](const string_type& str)
+	{
+		return str.size() >= prefix.size() && std::char_traits<char>::compare(str.data(), prefix.data(), prefix.size()) == 0;
+	}, bitmap);
+}
+
+template <std::size_t N, typename Code>
+void dictionary_column<N, Code>::select_contains(view_type sv, std::uint64_t* bitmap) const
+{
+	select([sv](const string_type& str) { return view_type(str).find(sv) != view_type::npos; }, bitmap);
+}
+
+template <std::size_t N, typename Code>
+void dictionary_column<N, Code>::select_range(view_type lo, view_type hi, std::uint64_t* bitmap) const
+{
+	select([lo, hi](const string_type& str)
+	{
+		const view_type v(str);
+		return v.compare(lo) >= 0 && v.compare(hi) < 0;
+	}, bitmap);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "inplace_string.h"
+
+// String of exactly N characters, built at compile time from a string literal. All its members are public, which
+// makes it a structural type usable as a template argument in C++20:
+//
+//   template <fixed_string Name, std::size_t N>
+//   struct field { static constexpr auto name = Name; inplace_string<N> value; };
+//
+//   using symbol = field<"Symbol"_fs, 15>;
+//
+// Comparisons with basic_inplace_string and string_view use the size N known at compile time, without Traits::length.
+template <std::size_t N, typename CharT = char>
+struct fixed_string
+{
+	using value_type = CharT;
+	using size_type = std::size_t;
+	using traits_type = std::char_traits<CharT>;
+
+	constexpr fixed_string(const CharT (&str)[N + 1]) noexcept :
+		chars{}
+	{
+		for (std::size_t i = 0; i < N; ++i)
+			chars[i] = str[i];
+	}
+
+	static constexpr size_type size() noexcept   { return N; }
+	static constexpr size_type length() noexcept { return N; }
+	static constexpr bool empty() noexcept       { return N == 0; }
+
+	constexpr const CharT* data() const noexcept  { return chars; }
+	constexpr const CharT* c_str() const noexcept { return chars; }
+	constexpr CharT operator[](size_type i) const noexcept { return chars[i]; }
+
+	constexpr operator basic_string_view<CharT, traits_type>() const noexcept { return {chars, N}; }
+
+	template <std::size_t M, typename Traits>
+	operator basic_inplace_string<M, CharT, Traits>() const
+	{
+		static_assert(N <= M, "fixed_string: does not fit in the basic_inplace_string");
+		return basic_inplace_string<M, CharT, Traits>(chars, N);
+	}
+
+	CharT chars[N + 1];
+};
+
+template <typename CharT, std::size_t M>
+fixed_string(const CharT (&)[M]) -> fixed_string<M - 1, CharT>;
+
+template <std::size_t N, std::size_t M, typename CharT>
+constexpr bool operator==(const fixed_string<N, CharT>& lhs, const fixed_string<M, CharT>& rhs) noexcept
+{
+	if (N != M)
+		return false;
+
+	for (std::size_t i = 0; i < N; ++i)
+		if (lhs.chars[i] != rhs.chars[i])
+			return false;
+	return true;
+}
+
+template <std::size_t N, std::size_t M, typename CharT>
+constexpr bool operator!=(const fixed_string<N, CharT>& lhs, const fixed_string<M, CharT>& rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
+template <std::size_t M, typename CharT, typename Traits, std::size_t N>
+inline bool operator==(const basic_inplace_string<M, CharT, Traits>& lhs, const fixed_string<N, CharT>& rhs) noexcept
+{
+	return N <= M && lhs.size() == N && Traits::compare(lhs.data(), rhs.chars, N) == 0;
+}
+
+template <std::size_t M, typename CharT, typename Traits, std::size_t N>
+inline bool operator==(const fixed_string<N, CharT>& lhs, const basic_inplace_string<M, CharT, Traits>& rhs) noexcept
+{
+	return rhs == lhs;
+}
+
+template <std::size_t M, typename CharT, typename Traits, std::size_t N>
+inline bool operator!=(const basic_inplace_string<M, CharT, Traits>& lhs, const fixed_string<N, CharT>& rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
+template <std::size_t M, typename CharT, typename Traits, std::size_t N>
+inline bool operator!=(const fixed_string<N, CharT>& lhs, const basic_inplace_string<M, CharT, Traits>& rhs) noexcept
+{
+	return !(rhs == lhs);
+}
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+
+// "Symbol"_fs is fixed_string<6>{"Symbol"}, usable as a template argument
+template <fixed_string S>
+constexpr auto operator""_fs() noexcept
+{
+	return S;
+}
+
+#endif
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <iterator>
+#include <vector>
+
+// Immutable sorted set of inplace_string<N> stored with front coding: each string is stored as the number of characters
+// it shares with the previous one, followed by the remaining characters. Every BlockSize strings, a restart point
+// stores a string in full, so that a lookup is a binary search over the restart strings followed by the decoding of a
+// single block. Sorted dictionaries with long common prefixes (e.g. option series) take a fraction of the N + 1 bytes
+// per string of an array.
+template <std::size_t N, std::size_t BlockSize = 16>
+class front_coded_set
+{
+public:
+	static_assert(N > 0 && N <= 255, "front_coded_set: sizes are stored on 8 bits");
+	static_assert(BlockSize > 0, "front_coded_set: blocks must hold at least one string");
+
+	using key_type = inplace_string<N>;
+	using value_type = key_type;
+	using size_type = std::size_t;
+	using view_type = basic_string_view<char, std::char_traits<char>>;
+
+	static constexpr const size_type npos = size_type(-1);
+	static constexpr const size_type block_size = BlockSize;
+
+	class const_iterator;
+	using iterator = const_iterator;
+
+	front_coded_set() = default;
+
+	// [first, last) must be sorted, duplicates are skipped.
+	template <typename InputIt, typename X = typename std::enable_if<detail::is_input_iterator<InputIt>::value>::type>
+	front_coded_set(InputIt first, InputIt last);
+
+	const_iterator begin() const noexcept;
+	const_iterator end() const noexcept;
+
+	size_type size() const noexcept       { return _size; }
+	bool empty() const noexcept           { return _size == 0; }
+	size_type block_count() const noexcept { return _restarts.size(); }
+
+	// Bytes used by the encoded strings and the restart points
+	size_type memory_usage() const noexcept { return _bytes.size() + _restarts.size() * sizeof(size_type); }
+
+	// Decodes the strings of block b into out, which must hold block_size strings. Returns the number of strings.
+	size_type decode_block(size_type b, key_type* out) const;
+
+	key_type operator[](size_type i) const;
+	key_type at(size_type i) const;
+
+	// Position of the first string not less than key, size() if none
+	size_type lower_bound(view_type key) const noexcept;
+
+	// Position of key, npos if not found
+	size_type find(view_type key) const noexcept;
+	bool contains(view_type key) const noexcept { return find(key) != npos; }
+
+private:
+	view_type restart_key(size_type b) const noexcept
+	{
+		const char* p = _bytes.data() + _restarts[b];
+		return {p + 2, static_cast<unsigned char>(p[1])};
+	}
+
+	// Buffer of decode(), large enough for fixed-size copies
+	using buffer_type = char[2 * N];
+
+	// Applies the entry at p to buf, which holds the previous string, and returns the next entry. The suffix is always
+	// copied as N bytes, a fixed-size copy done with a few vector moves: the encoded strings are followed by N bytes of
+	// padding, and the characters copied past the suffix are overwritten before being read.
+	static const char* decode(const char* p, char* buf, size_type& sz) noexcept
+	{
+		const size_type shared = static_cast<unsigned char>(p[0]);
+		const size_type suffix = static_cast<unsigned char>(p[1]);
+		std::memcpy(buf + shared, p + 2, N);
+		sz = shared + suffix;
+		return p + 2 + suffix;
+	}
+
+	std::vector<char> _bytes;         // [shared][suffix size][suffix characters] per string, then N bytes of padding
+	std::vector<size_type> _restarts; // offset of the first string of each block, stored with shared = 0
+	size_type _size = 0;
+};
+
+template <std::size_t N, std::size_t BlockSize>
+constexpr const typename front_coded_set<N, BlockSize>::size_type front_coded_set<N, BlockSize>::npos;
+
+template <std::size_t N, std::size_t BlockSize>
+constexpr const typename front_coded_set<N, BlockSize>::size_type front_coded_set<N, BlockSize>::block_size;
+
+// Forward iterator decoding the strings one after the other
+template <std::size_t N, std::size_t BlockSize>
+class front_coded_set<N, BlockSize>::const_iterator
+{
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = key_type;
+	using difference_type = std::ptrdiff_t;
+	using pointer = const key_type*;
+	using reference = const key_type&;
+
+	const_iterator() = default;
+
+	reference operator*() const noexcept { return _str; }
+	pointer operator->() const noexcept  { return &_str; }
+
+	const_iterator& operator++() noexcept
+	{
+		if (++_index < _set->size())
+			load();
+		return *this;
+	}
+
+	const_iterator operator++(int) noexcept { const_iterator it = *this; ++*this; return it; }
+
+	friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) noexcept { return lhs._index == rhs._index; }
+	friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) noexcept { return lhs._index != rhs._index; }
+
+private:
+	friend class front_coded_set;
+
+	const_iterator(const front_coded_set* set, size_type index) noexcept :
+		_set(set),
+		_index(index),
+		_next(set->_bytes.data())
+	{
+		if (_index < _set->size())
+			load();
+	}
+
+	void load() noexcept
+	{
+		size_type sz;
+		_next = decode(_next, _buf, sz);
+		_str = key_type(_buf, sz);
+	}
+
+	const front_coded_set* _set = nullptr;
+	size_type _index = 0;
+	const char* _next = nullptr;
+	buffer_type _buf = {};
+	key_type _str;
+};
+
+template <std::size_t N, std::size_t BlockSize>
+template <typename InputIt, typename X>
+front_coded_set<N, BlockSize>::front_coded_set(InputIt first, InputIt last)
+{
+	key_type prev;
+
+	for (; first != last; ++first)
+	{
+		const key_type str(*first);
+
+		if (_size > 0)
+		{
+			if (str < prev)
+				detail::throw_helper<std::invalid_argument>("front_coded_set: range not sorted");
+			if (str == prev)
+				continue;
+		}
+
+		size_type shared = 0;
+		if (_size % BlockSize == 0)
+		{
+			_restarts.push_back(_bytes.size());
+		}
+		else
+		{
+			const size_type sz = std::min(str.size(), prev.size());
+			while (shared < sz && str[shared] == prev[shared])
+				++shared;
+		}
+
+		_bytes.push_back(static_cast<char>(shared));
+		_bytes.push_back(static_cast<char>(str.size() - shared));
+		_bytes.insert(_bytes.end(), str.data() + shared, str.data() + str.size());
+
+		prev = str;
+		++_size;
+	}
+
+	if (_size > 0)
+		_bytes.resize(_bytes.size() + N);
+
+	_bytes.shrink_to_fit();
+	_restarts.shrink_to_fit();
+}
+
+template <std::size_t N, std::size_t BlockSize>
+typename front_coded_set<N, BlockSize>::const_iterator front_coded_set<N, BlockSize>::begin() const noexcept
+{
+	return const_iterator(this, 0);
+}
+
+template <std::size_t N, std::size_t BlockSize>
+typename front_coded_set<N, BlockSize>::const_iterator front_coded_set<N, BlockSize>::end() const noexcept
+{
+	return const_iterator(this, _size);
+}
+
+template <std::size_t N, std::size_t BlockSize>
+typename front_coded_set<N, BlockSize>::size_type front_coded_set<N, BlockSize>::decode_block(size_type b, key_type* out) const
+{
+	if (b >= block_count())
+		detail::throw_helper<std::out_of_range>("front_coded_set::decode_block: out of range");
+
+	const size_type count = std::min(BlockSize, _size - b * BlockSize);
+	const char* p = _bytes.data() + _restarts[b];
+
+	// each string is decoded in place over the previous one
+	buffer_type buf = {};
+	for (size_type i = 0; i < count; ++i)
+	{
+		size_type sz;
+		p = decode(p, buf, sz);
+		out[i] = key_type(buf, sz);
+	}
+	return count;
+}
+
+template <std::size_t N, std::size_t BlockSize>
+typename front_coded_set<N, BlockSize>::key_type front_coded_set<N, BlockSize>::operator[](size_type i) const
+{
+	assert(i < size());
+
+	const char* p = _bytes.data() + _restarts[i / BlockSize];
+
+	buffer_type buf = {};
+	size_type sz = 0;
+	for (size_type j = 0; j <= i % BlockSize; ++j)
+		p = decode(p, buf, sz);
+	return key_type(buf, sz);
+}
+
+template <std::size_t N, std::size_t BlockSize>
+typename front_coded_set<N, BlockSize>::key_type front_coded_set<N, BlockSize>::at(size_type i) const
+{
+	if (i >= size())
+		detail::throw_helper<std::out_of_range>("front_coded_set::at: out of range");
+
+	return (*this)[i];
+}
+
+template <std::size_t N, std::size_t BlockSize>
+typename front_coded_set<N, BlockSize>::size_type front_coded_set<N, BlockSize>::lower_bound(view_type key) const noexcept
+{
+	// last block starting with a string not greater than key
+	size_type lo = 0;
+	size_type hi = block_count();
+	while (lo < hi)
+	{
+		const size_type mid = lo + (hi - lo) / 2;
+		if (restart_key(mid).compare(key) <= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == 0)
+		return 0;
+
+	const size_type b = lo - 1;
+	const size_type count = std::min(BlockSize, _size - b * BlockSize);
+	const char* p = _bytes.data() + _restarts[b];
+
+	buffer_type buf = {};
+	for (size_type i = 0; i < count; ++i)
+	{
+		size_type sz;
+		p = decode(p, buf, sz);
+		if (view_type(buf, sz).compare(key) >= 0)
+			return b * BlockSize + i;
+	}
+	return b * BlockSize + count;
+}
+
+template <std::size_t N, std::size_t BlockSize>
+typename front_coded_set<N, BlockSize>::size_type front_coded_set<N, BlockSize>::find(view_type key) const noexcept
+{
+	if (key.size() > N)
+		return npos;
+
+	const size_type i = lower_bound(key);
+	return i < size() && (*this)[i] == key ? i : npos;
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace detail
+{
+
+// First 8 characters, zero-padded and in big-endian order: prefix_key(a) < prefix_key(b) implies a < b.
+inline std::uint64_t prefix_key(const char* str, std::size_t size) noexcept
+{
+	std::uint64_t v = 0;
+	std::memcpy(&v, str, std::min(size, sizeof(v)));
+	return to_big_endian(v);
+}
+
+// Search tree over a sorted array in Eytzinger (BFS) order: the nodes visited by a lookup are packed at the beginning
+// of the array, and the next levels can be prefetched. Each node holds the prefix_key of the element, so that only the
+// elements sharing their first 8 characters with the searched key are compared with Traits.
+class eytzinger_index
+{
+public:
+	using view_type = basic_string_view<char, std::char_traits<char>>;
+
+	eytzinger_index() : _nodes(1) {}
+
+	template <typename GetKey>
+	eytzinger_index(std::size_t size, GetKey get_key);
+
+	// Position of the first element not less than key in the sorted array, size if none.
+	template <typename GetKey>
+	std::size_t lower_bound(view_type key, GetKey get_key) const noexcept;
+
+private:
+	struct node
+	{
+		std::uint64_t prefix;
+		std::size_t index;
+	};
+
+	template <typename GetKey>
+	void build(std::size_t& i, std::size_t k, GetKey& get_key);
+
+	std::vector<node> _nodes; // 1-based, _nodes[0] is unused
+};
+
+template <typename GetKey>
+eytzinger_index::eytzinger_index(std::size_t size, GetKey get_key) :
+	_nodes(size + 1)
+{
+	std::size_t i = 0;
+	build(i, 1, get_key);
+}
+
+template <typename GetKey>
+void eytzinger_index::build(std::size_t& i, std::size_t k, GetKey& get_key)
+{
+	if (k >= _nodes.size())
+		return;
+
+	build(i, 2 * k, get_key);
+
+	const view_type key = get_key(i);
+	_nodes[k] = node{prefix_key(key.data(), key.size()), i};
+	++i;
+
+	build(i, 2 * k + 1, get_key);
+}
+
+template <typename GetKey>
+std::size_t eytzinger_index::lower_bound(view_type key, GetKey get_key) const noexcept
+{
+	const std::uint64_t prefix = prefix_key(key.data(), key.size());
+	const std::size_t n = _nodes.size() - 1;
+
+	std::size_t k = 1;
+	while (k <= n)
+	{
+#if defined(__GNUC__)
+		__builtin_prefetch(_nodes.data() + std::min(16 * k, n));
+#endif
+		const node& nd = _nodes[k];
+		const bool less = nd.prefix < prefix || (nd.prefix == prefix && get_key(nd.index).compare(key) < 0);
+		k = 2 * k + less;
+	}
+
+	// the last left turn is the lower bound: strip the trailing right turns, and that left turn
+	while (k & 1)
+		k >>= 1;
+	k >>= 1;
+
+	return k == 0 ? n : _nodes[k].index;
+}
+
+}
+
+// Immutable sorted set of inplace_string<N>, for tables built once and queried many times. Lookups go through an
+// eytzinger_index and accept anything convertible to a string_view, without building a key_type.
+template <std::size_t N>
+class inplace_flat_set
+{
+public:
+	using key_type = inplace_string<N>;
+	using value_type = key_type;
+	using size_type = std::size_t;
+	using view_type = basic_string_view<char, std::char_traits<char>>;
+	using const_iterator = typename std::vector<key_type>::const_iterator;
+	using iterator = const_iterator;
+
+	inplace_flat_set() = default;
+	explicit inplace_flat_set(std::vector<key_type> keys);
+	inplace_flat_set(std::initializer_list<key_type> ilist) : inplace_flat_set(std::vector<key_type>(ilist)) {}
+
+	const_iterator begin() const noexcept { return _keys.begin(); }
+	const_iterator end() const noexcept   { return _keys.end(); }
+
+	size_type size() const noexcept { return _keys.size(); }
+	bool empty() const noexcept     { return _keys.empty(); }
+
+	const_iterator lower_bound(view_type key) const noexcept;
+	const_iterator find(view_type key) const noexcept;
+	size_type count(view_type key) const noexcept { return find(key) != end(); }
+	bool contains(view_type key) const noexcept   { return find(key) != end(); }
+
+private:
+	view_type key_at(std::size_t i) const noexcept { return _keys[i]; }
+
+	std::vector<key_type> _keys;
+	detail::eytzinger_index _index;
+};
+
+template <std::size_t N>
+inplace_flat_set<N>::inplace_flat_set(std::vector<key_type> keys) :
+	_keys(std::move(keys))
+{
+	std::sort(_keys.begin(), _keys.end());
+	_keys.erase(std::unique(_keys.begin(), _keys.end()), _keys.end());
+
+	_index = detail::eytzinger_index(_keys.size(), [this](std::size_t i) { return key_at(i); });
+}
+
+template <std::size_t N>
+typename inplace_flat_set<N>::const_iterator inplace_flat_set<N>::lower_bound(view_type k) const noexcept
+{
+	const std::size_t i = _index.lower_bound(k, [this](std::size_t j) { return key_at(j); });
+	return begin() + static_cast<std::ptrdiff_t>(i);
+}
+
+template <std::size_t N>
+typename inplace_flat_set<N>::const_iterator inplace_flat_set<N>::find(view_type k) const noexcept
+{
+	const const_iterator it = lower_bound(k);
+	return it != end() && *it == k ? it : end();
+}
+
+// Immutable sorted map from inplace_string<N> to T, see inplace_flat_set. Keys are unique, the first occurrence wins.
+template <std::size_t N, typename T>
+class inplace_flat_map
+{
+public:
+	using key_type = inplace_string<N>;
+	using mapped_type = T;
+	using value_type = std::pair<key_type, T>;
+	using size_type = std::size_t;
+	using view_type = basic_string_view<char, std::char_traits<char>>;
+	using const_iterator = typename std::vector<value_type>::const_iterator;
+	using iterator = const_iterator;
+
+	inplace_flat_map() = default;
+	explicit inplace_flat_map(std::vector<value_type> values);
+	inplace_flat_map(std::initializer_list<value_type> ilist) : inplace_flat_map(std::vector<value_type>(ilist)) {}
+
+	const_iterator begin() const noexcept { return _values.begin(); }
+	const_iterator end() const noexcept   { return _values.end(); }
+
+	size_type size() const noexcept { return _values.size(); }
+	bool empty() const noexcept     { return _values.empty(); }
+
+	const_iterator lower_bound(view_type key) const noexcept;
+	const_iterator find(view_type key) const noexcept;
+	size_type count(view_type key) const noexcept { return find(key) != end(); }
+	bool contains(view_type key) const noexcept   { return find(key) != end(); }
+
+	const T& at(view_type key) const;
+
+private:
+	view_type key_at(std::size_t i) const noexcept { return _values[i].first; }
+
+	std::vector<value_type> _values;
+	detail::eytzinger_index _index;
+};
+
+template <std::size_t N, typename T>
+inplace_flat_map<N, T>::inplace_flat_map(std::vector<value_type> values) :
+	_values(std::move(values))
+{
+	auto less = [](const value_type& lhs, const value_type& rhs) { return lhs.first < rhs.first; };
+	auto equal = [](const value_type& lhs, const value_type& rhs) { return lhs.first == rhs.first; };
+
+	std::stable_sort(_values.begin(), _values.end(), less);
+	_values.erase(std::unique(_values.begin(), _values.end(), equal), _values.end());
+
+	_index = detail::eytzinger_index(_values.size(), [this](std::size_t i) { return key_at(i); });
+}
+
+template <std::size_t N, typename T>
+typename inplace_flat_map<N, T>::const_iterator inplace_flat_map<N, T>::lower_bound(view_type k) const noexcept
+{
+	const std::size_t i = _index.lower_bound(k, [this](std::size_t j) { return key_at(j); });
+	return begin() + static_cast<std::ptrdiff_t>(i);
+}
+
+template <std::size_t N, typename T>
+typename inplace_flat_map<N, T>::const_iterator inplace_flat_map<N, T>::find(view_type k) const noexcept
+{
+	const const_iterator it = lower_bound(k);
+	return it != end() && it->first == k ? it : end();
+}
+
+template <std::size_t N, typename T>
+const T& inplace_flat_map<N, T>::at(view_type k) const
+{
+	const const_iterator it = find(k);
+	if (it == end())
+		detail::throw_helper<std::out_of_range>("inplace_flat_map::at: key not found");
+
+	return it->second;
+}
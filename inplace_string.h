@@ -2,9 +2,16 @@
 
 #include <array>
 #include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <algorithm>
 #include <type_traits>
 #include <limits>
+#include <new>
+#include <stdexcept>
+#include <istream>
+#include <locale>
 
 #if defined _NO_EXCEPTIONS
 #include <iostream>
@@ -32,6 +39,19 @@ inline void throw_helper(const std::string& msg)
 #endif
 }
 
+// std::bad_alloc carries no message
+template <>
+inline void throw_helper<std::bad_alloc>(const std::string& msg)
+{
+#ifndef _NO_EXCEPTIONS
+	(void)msg;
+	throw std::bad_alloc();
+#else
+	std::cerr << msg.c_str() << "\n";
+	std::abort();
+#endif
+}
+
 template <typename It, typename ItUp>
 struct is_iterator_convertible_to :
 		std::integral_constant<bool,
@@ -60,6 +80,17 @@ struct is_input_iterator_tag {};
 template <typename CharT, typename Traits>
 const CharT* search_substring(const CharT* first1, const CharT* last1, const CharT* first2, const CharT* last2);
 
+inline std::uint64_t to_big_endian(std::uint64_t v) noexcept
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return v;
+#elif defined(_MSC_VER)
+	return _byteswap_uint64(v);
+#else
+	return __builtin_bswap64(v);
+#endif
+}
+
 }
 
 template <
@@ -90,7 +121,7 @@ private:
 public:
 	static constexpr const size_type npos = static_cast<size_type>(-1);
 
-	static_assert(std::is_pod<value_type>::value, "CharT type of basic_inplace_string must be a POD");
+	static_assert(std::is_trivial<value_type>::value && std::is_standard_layout<value_type>::value, "CharT type of basic_inplace_string must be a POD");
 	static_assert(std::is_same<value_type, typename traits_type::char_type>::value, "CharT type must be the same type as Traits::char_type");
 	static_assert(N <= std::numeric_limits<static_size_type>::max(), "N must be smaller than the maximum static_size possible with this CharT type");
 
@@ -265,6 +296,18 @@ public:
 	size_type find(value_type ch, size_type pos = 0) const noexcept;
 	size_type find(basic_string_view<CharT, Traits> sv, size_type pos = 0) const noexcept;
 
+	// Raw object representation, zero-extended, of strings whose storage fits in 8 (resp. 16) bytes, i.e.
+	// inplace_string<N> with N <= 7 (resp. N <= 15). As the characters past the terminator are always zero, two
+	// strings are equal iff their representations are equal.
+	std::uint64_t as_uint64() const noexcept;
+	std::array<std::uint64_t, 2> as_uint128() const noexcept;
+
+	template <std::size_t M, typename C, typename T>
+	friend std::basic_istream<C, T>& operator>>(std::basic_istream<C, T>& is, basic_inplace_string<M, C, T>& str);
+
+	template <std::size_t M, typename C, typename T>
+	friend std::basic_istream<C, T>& getline(std::basic_istream<C, T>& is, basic_inplace_string<M, C, T>& str, C delim);
+
 private:
 	template <typename InputIt>
 	basic_inplace_string(InputIt first, InputIt last, detail::is_exactly_input_iterator_tag);
@@ -295,19 +338,45 @@ private:
 		return static_cast<size_type>(_data[N]);
 	}
 
+	// Terminates the string at new_sz. When shrinking, the characters left over from the previous content are zeroed
+	// as well: everything between the terminator and _data[N] is always value-initialized.
+	void truncate(size_type old_sz, size_type new_sz) noexcept
+	{
+		traits_type::assign(&_data[new_sz], new_sz < old_sz ? old_sz - new_sz : 1, value_type{});
+		set_size(new_sz);
+	}
+
 	std::array<value_type, N + 1> _data;
 };
 
+namespace detail
+{
+
+// Checks the layout that copies with memcpy, trivial relocation and the file formats rely on. Instantiated by the
+// default constructor and by is_trivially_relocatable, so that types only copied or mapped are checked as well.
+template <typename String>
+struct inplace_string_layout : std::true_type
+{
+	static_assert(std::is_trivially_copyable<String>::value, "basic_inplace_string must be trivially copyable");
+	static_assert(sizeof(String) == (String::max_size() + 1) * sizeof(typename String::value_type),
+				  "basic_inplace_string must not have padding");
+};
+
+}
+
 template <std::size_t N, typename CharT, typename Traits>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string() noexcept
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string() noexcept :
+	_data{}
 {
-	_data[0] = value_type{};
+	static_assert(detail::inplace_string_layout<basic_inplace_string>::value, "basic_inplace_string: unexpected layout");
+
 	set_size(0);
 }
 
 template <std::size_t N, typename CharT, typename Traits>
 template <std::size_t M>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const value_type(&str)[M]) noexcept
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const value_type(&str)[M]) noexcept :
+	_data{}
 {
 	constexpr size_type sz = M - 1;
 	static_assert(sz <= max_size(), "basic_inplace_string: size exceeds maximum capacity");
@@ -315,7 +384,6 @@ basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const value_type(&s
 	for (size_type i = 0; i < sz; ++i)
 		traits_type::assign(_data[i], str[i]);
 
-	traits_type::assign(_data[sz], value_type{});
 	set_size(sz);
 }
 
@@ -327,14 +395,16 @@ basic_inplace_string<N, CharT, Traits>::basic_inplace_string(ValueTypePtr str) :
 }
 
 template <std::size_t N, typename CharT, typename Traits>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(size_type count, value_type ch)
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(size_type count, value_type ch) :
+	_data{}
 {
 	set_size(0);
 	insert(static_cast<size_type>(0), count, ch);
 }
 
 template <std::size_t N, typename CharT, typename Traits>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const std::basic_string<CharT, Traits>& other, size_type pos)
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const std::basic_string<CharT, Traits>& other, size_type pos) :
+	_data{}
 {
 	if (pos > other.size())
 		detail::throw_helper<std::out_of_range>("basic_inplace_string: out of range");
@@ -344,7 +414,8 @@ basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const std::basic_st
 }
 
 template <std::size_t N, typename CharT, typename Traits>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const basic_inplace_string& other, size_type pos)
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const basic_inplace_string& other, size_type pos) :
+	_data{}
 {
 	if (pos > other.size())
 		detail::throw_helper<std::out_of_range>("basic_inplace_string: out of range");
@@ -354,7 +425,8 @@ basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const basic_inplace
 }
 
 template <std::size_t N, typename CharT, typename Traits>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const std::basic_string<CharT, Traits>& other, size_type pos, size_type count)
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const std::basic_string<CharT, Traits>& other, size_type pos, size_type count) :
+	_data{}
 {
 	if (pos > other.size())
 		detail::throw_helper<std::out_of_range>("basic_inplace_string: out of range");
@@ -364,7 +436,8 @@ basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const std::basic_st
 }
 
 template <std::size_t N, typename CharT, typename Traits>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const basic_inplace_string& other, size_type pos, size_type count)
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const basic_inplace_string& other, size_type pos, size_type count) :
+	_data{}
 {
 	if (pos > other.size())
 		detail::throw_helper<std::out_of_range>("basic_inplace_string: out of range");
@@ -374,7 +447,8 @@ basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const basic_inplace
 }
 
 template <std::size_t N, typename CharT, typename Traits>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const value_type* str, size_type count)
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const value_type* str, size_type count) :
+	_data{}
 {
 	set_size(0);
 	insert(static_cast<size_type>(0), str, count);
@@ -400,7 +474,8 @@ basic_inplace_string<N, CharT, Traits>::basic_inplace_string(basic_string_view<C
 
 template <std::size_t N, typename CharT, typename Traits>
 template <typename T, typename X>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const T& t, size_type pos, size_type n)
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(const T& t, size_type pos, size_type n) :
+	_data{}
 {
 	set_size(0);
 
@@ -422,7 +497,8 @@ basic_inplace_string<N, CharT, Traits>::basic_inplace_string(InputIt first, Inpu
 
 template <std::size_t N, typename CharT, typename Traits>
 template <typename InputIt>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(InputIt first, InputIt last, detail::is_exactly_input_iterator_tag tag)
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(InputIt first, InputIt last, detail::is_exactly_input_iterator_tag tag) :
+	_data{}
 {
 	set_size(0);
 	insert(cbegin(), first, last, tag);
@@ -430,7 +506,8 @@ basic_inplace_string<N, CharT, Traits>::basic_inplace_string(InputIt first, Inpu
 
 template <std::size_t N, typename CharT, typename Traits>
 template <typename InputIt>
-basic_inplace_string<N, CharT, Traits>::basic_inplace_string(InputIt first, InputIt last, detail::is_input_iterator_tag tag)
+basic_inplace_string<N, CharT, Traits>::basic_inplace_string(InputIt first, InputIt last, detail::is_input_iterator_tag tag) :
+	_data{}
 {
 	set_size(0);
 	insert(cbegin(), first, last, tag);
@@ -567,7 +644,7 @@ basic_inplace_string<N, CharT, Traits>::insert(const_iterator pos, InputIt first
 
 	for (; first != last; ++first, ++count)
 	{
-		traits_type::move(&_data[index + count + 1], &_data[index + count], sz - index + count);
+		traits_type::move(&_data[index + count + 1], &_data[index + count], sz - index);
 		traits_type::assign(_data[index + count], *first);
 	}
 
@@ -643,10 +720,7 @@ basic_inplace_string<N, CharT, Traits>::erase(size_type index, size_type count)
 
 	traits_type::move(_data.data() + index, _data.data() + index + count, sz - index - count);
 
-	sz -= count;
-	traits_type::assign(_data[sz], value_type{});
-
-	set_size(sz);
+	truncate(sz, sz - count);
 	return *this;
 }
 
@@ -891,11 +965,13 @@ basic_inplace_string<N, CharT, Traits>::replace(const_iterator first, const_iter
 		traits_type::assign(_data[pos1 + count2], *first2);
 	}
 
+	if (count2 < count1)
+		traits_type::move(_data.data() + pos1 + count2, _data.data() + pos1 + count1, sz - pos1 - count1);
+
 	const difference_type new_bytes = static_cast<difference_type>(count2 - count1);
 	const size_type new_size = sz + static_cast<size_type>(new_bytes);
 
-	traits_type::assign(_data[new_size], value_type{});
-	set_size(new_size);
+	truncate(sz, new_size);
 
 	return *this;
 }
@@ -926,8 +1002,7 @@ basic_inplace_string<N, CharT, Traits>::replace(const_iterator first, const_iter
 	for (auto it = first2; it != last2; ++it, ++p)
 		traits_type::assign(*p, *it);
 
-	traits_type::assign(_data[new_size], value_type{});
-	set_size(new_size);
+	truncate(sz, new_size);
 
 	return *this;
 }
@@ -946,13 +1021,12 @@ basic_inplace_string<N, CharT, Traits>::replace(size_type pos1, size_type count1
 	if (new_size > max_size())
 		detail::throw_helper<std::length_error>("basic_inplace_string::replace: exceed maximum string length");
 
-	traits_type::move(_data.data() + pos1 + count2, _data.data() + pos1 + count1, sz - pos1);
+	traits_type::move(_data.data() + pos1 + count2, _data.data() + pos1 + count1, sz - std::min(sz, pos1 + count1));
 
 	for (size_type i = 0; i != count2; ++i)
 		traits_type::assign(_data[pos1 + i], str[i]);
 
-	traits_type::assign(_data[new_size], value_type{});
-	set_size(new_size);
+	truncate(std::max(sz, pos1 + count2), new_size);
 
 	return *this;
 }
@@ -997,8 +1071,7 @@ basic_inplace_string<N, CharT, Traits>::replace(size_type pos1, size_type count1
 	traits_type::move(_data.data() + pos1 + count2, _data.data() + pos1 + count1, size() - pos1 - count1);
 	traits_type::assign(_data.data() + pos1, count2, ch);
 
-	traits_type::assign(_data[new_size], value_type{});
-	set_size(new_size);
+	truncate(sz, new_size);
 
 	return *this;
 }
@@ -1131,16 +1204,33 @@ void basic_inplace_string<N, CharT, Traits>::resize(size_type new_size, value_ty
 	if (static_cast<difference_type>(new_size - sz) > 0)
 		traits_type::assign(&_data[sz], new_size - sz, ch);
 
-	traits_type::assign(_data[new_size], value_type{});
-	set_size(new_size);
+	truncate(sz, new_size);
 }
 
 template <std::size_t N, typename CharT, typename Traits>
 void basic_inplace_string<N, CharT, Traits>::swap(basic_inplace_string& other) noexcept
 {
-	basic_inplace_string s(other);
-	other = *this;
-	*this = s;
+	std::swap(_data, other._data);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+std::uint64_t basic_inplace_string<N, CharT, Traits>::as_uint64() const noexcept
+{
+	static_assert(sizeof(_data) <= sizeof(std::uint64_t), "basic_inplace_string::as_uint64: storage exceeds 8 bytes");
+
+	std::uint64_t v = 0;
+	std::memcpy(&v, _data.data(), sizeof(_data));
+	return v;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+std::array<std::uint64_t, 2> basic_inplace_string<N, CharT, Traits>::as_uint128() const noexcept
+{
+	static_assert(sizeof(_data) <= 2 * sizeof(std::uint64_t), "basic_inplace_string::as_uint128: storage exceeds 16 bytes");
+
+	std::array<std::uint64_t, 2> v{};
+	std::memcpy(v.data(), _data.data(), sizeof(_data));
+	return v;
 }
 
 template <std::size_t N, typename CharT, typename Traits>
@@ -1149,6 +1239,79 @@ inline std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, T
 	return os.write(str.data(), static_cast<std::streamsize>(str.size()));
 }
 
+// Extracts a whitespace-delimited word, as for std::string, writing the characters in place. A word longer than the
+// capacity (or than is.width() if set) is cut: its first characters are stored, the rest is left in the stream and
+// failbit is set when the capacity is exceeded.
+template <std::size_t N, typename CharT, typename Traits>
+std::basic_istream<CharT, Traits>& operator>>(std::basic_istream<CharT, Traits>& is, basic_inplace_string<N, CharT, Traits>& str)
+{
+	using int_type = typename Traits::int_type;
+
+	const typename std::basic_istream<CharT, Traits>::sentry sentry(is);
+	if (!sentry)
+		return is;
+
+	const std::streamsize width = is.width();
+	const std::size_t limit = width > 0 && static_cast<std::size_t>(width) < N ? static_cast<std::size_t>(width) : N;
+	const std::ctype<CharT>& ctype = std::use_facet<std::ctype<CharT>>(is.getloc());
+	std::basic_streambuf<CharT, Traits>* buf = is.rdbuf();
+
+	str.clear();
+	std::ios_base::iostate state = std::ios_base::goodbit;
+	std::size_t count = 0;
+
+	for (int_type c = buf->sgetc();; c = buf->snextc())
+	{
+		if (Traits::eq_int_type(c, Traits::eof()))
+		{
+			state |= std::ios_base::eofbit;
+			break;
+		}
+
+		const CharT ch = Traits::to_char_type(c);
+		if (ctype.is(std::ctype_base::space, ch))
+			break;
+
+		if (count == limit)
+		{
+			if (limit == N)
+				state |= std::ios_base::failbit;
+			break;
+		}
+
+		Traits::assign(str._data[count++], ch);
+	}
+
+	str.set_size(count);
+	is.width(0);
+
+	if (count == 0)
+		state |= std::ios_base::failbit;
+	is.setstate(state);
+	return is;
+}
+
+// Extracts characters up to delim, which is extracted but not stored, as for std::string. The characters are read by
+// std::istream::getline straight into the string: a line longer than the capacity sets failbit after storing its first N
+// characters, the rest of the line being left in the stream.
+template <std::size_t N, typename CharT, typename Traits>
+std::basic_istream<CharT, Traits>& getline(std::basic_istream<CharT, Traits>& is, basic_inplace_string<N, CharT, Traits>& str, CharT delim)
+{
+	str.clear();
+	is.getline(str._data.data(), static_cast<std::streamsize>(N + 1), delim);
+
+	// gcount() includes the delimiter, unless the line ended the input or was cut
+	const std::size_t count = static_cast<std::size_t>(is.gcount());
+	str.set_size(is.eof() || is.fail() ? count : count - 1);
+	return is;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+std::basic_istream<CharT, Traits>& getline(std::basic_istream<CharT, Traits>& is, basic_inplace_string<N, CharT, Traits>& str)
+{
+	return getline(is, str, is.widen('\n'));
+}
+
 template <std::size_t N, std::size_t M, typename CharT, typename Traits>
 inline bool operator==(const basic_inplace_string<N, CharT, Traits>& lhs,
 					   const basic_inplace_string<M, CharT, Traits>& rhs)
@@ -1395,6 +1558,98 @@ inline const CharT* search_substring(const CharT* first1, const CharT* last1, co
 
 }
 
+namespace detail
+{
+
+template <std::size_t N, typename CharT>
+using fits_uint64 = std::integral_constant<bool, (N + 1) * sizeof(CharT) <= sizeof(std::uint64_t)>;
+
+inline std::size_t mix_uint64(std::uint64_t v) noexcept
+{
+	v ^= v >> 33;
+	v *= 0xff51afd7ed558ccdULL;
+	v ^= v >> 33;
+	v *= 0xc4ceb9fe1a85ec53ULL;
+	v ^= v >> 33;
+	return static_cast<std::size_t>(v);
+}
+
+// Byte-swapped representation: the characters become the most significant bytes, followed by the size. The size byte
+// is stored as N - size(), hence flipped so that a prefix orders before the longer string.
+template <std::size_t N, typename Traits>
+inline std::uint64_t ordering_key(const basic_inplace_string<N, char, Traits>& str, std::true_type) noexcept
+{
+	return to_big_endian(str.as_uint64()) ^ (std::uint64_t{0xff} << (8 * (7 - N)));
+}
+
+template <std::size_t N, typename Traits>
+inline std::array<std::uint64_t, 2> ordering_key(const basic_inplace_string<N, char, Traits>& str, std::false_type) noexcept
+{
+	const std::array<std::uint64_t, 2> v = str.as_uint128();
+	return {{to_big_endian(v[0]), to_big_endian(v[1]) ^ (std::uint64_t{0xff} << (8 * (15 - N)))}};
+}
+
+// Word hashed by inplace_string_integer_hash, before mixing
+template <typename String>
+inline std::uint64_t integer_hash_input(const String& str, std::true_type) noexcept
+{
+	return str.as_uint64();
+}
+
+template <typename String>
+inline std::uint64_t integer_hash_input(const String& str, std::false_type) noexcept
+{
+	const std::array<std::uint64_t, 2> v = str.as_uint128();
+	return v[0] ^ (v[1] * 0x9e3779b97f4a7c15ULL);
+}
+
+}
+
+// Comparators and hasher for basic_inplace_string of up to 16 bytes, operating on as_uint64()/as_uint128() instead
+// of Traits. Ordering is only provided for single byte characters and matches operator< of std::char_traits<char>.
+struct inplace_string_integer_equal
+{
+	template <std::size_t N, typename CharT, typename Traits>
+	bool operator()(const basic_inplace_string<N, CharT, Traits>& lhs, const basic_inplace_string<N, CharT, Traits>& rhs) const noexcept
+	{
+		return equal(lhs, rhs, detail::fits_uint64<N, CharT>{});
+	}
+
+private:
+	template <typename String>
+	static bool equal(const String& lhs, const String& rhs, std::true_type) noexcept { return lhs.as_uint64() == rhs.as_uint64(); }
+
+	template <typename String>
+	static bool equal(const String& lhs, const String& rhs, std::false_type) noexcept { return lhs.as_uint128() == rhs.as_uint128(); }
+};
+
+struct inplace_string_integer_less
+{
+	template <std::size_t N, typename Traits>
+	bool operator()(const basic_inplace_string<N, char, Traits>& lhs, const basic_inplace_string<N, char, Traits>& rhs) const noexcept
+	{
+		using tag = detail::fits_uint64<N, char>;
+		return detail::ordering_key(lhs, tag{}) < detail::ordering_key(rhs, tag{});
+	}
+};
+
+struct inplace_string_integer_hash
+{
+	template <std::size_t N, typename CharT, typename Traits>
+	std::size_t operator()(const basic_inplace_string<N, CharT, Traits>& str) const noexcept
+	{
+		return detail::mix_uint64(detail::integer_hash_input(str, detail::fits_uint64<N, CharT>{}));
+	}
+};
+
+// Objects which can be moved to another address with memcpy/memmove, without running their constructor or destructor.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <std::size_t N, typename CharT, typename Traits>
+struct is_trivially_relocatable<basic_inplace_string<N, CharT, Traits>> :
+	std::integral_constant<bool, detail::inplace_string_layout<basic_inplace_string<N, CharT, Traits>>::value> {};
+
 template <std::size_t N> using inplace_string = basic_inplace_string<N, char>;
 template <std::size_t N> using inplace_wstring = basic_inplace_string<N, wchar_t>;
 template <std::size_t N> using inplace_u16string = basic_inplace_string<N, char16_t>;
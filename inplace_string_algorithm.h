@@ -0,0 +1,595 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INPLACE_STRING_SSE2
+#include <immintrin.h>
+#endif
+
+namespace detail
+{
+
+inline unsigned count_trailing_zeros(std::uint64_t v) noexcept
+{
+	assert(v != 0);
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, v);
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+}
+
+#if defined(INPLACE_STRING_SSE2)
+
+// Byte-wise equality of a full register: one bit per byte in the result
+#if defined(__AVX2__)
+struct simd_bytes
+{
+	using type = __m256i;
+	static constexpr std::size_t width = 32;
+
+	static type load(const unsigned char* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	static std::uint64_t equal(type a, type b) noexcept { return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b))); }
+};
+#else
+struct simd_bytes
+{
+	using type = __m128i;
+	static constexpr std::size_t width = 16;
+
+	static type load(const unsigned char* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+	static std::uint64_t equal(type a, type b) noexcept { return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))); }
+};
+#endif
+
+#endif
+
+// Bit i is set iff flags[i] is 1, for 64 flags of 0 or 1
+inline std::uint64_t pack_bits(const std::uint8_t* flags) noexcept
+{
+#if defined(INPLACE_STRING_SSE2)
+	std::uint64_t bits = 0;
+	for (std::size_t i = 0; i < 64; i += 16)
+	{
+		// moves the flag of each byte to its sign bit
+		const __m128i v = _mm_slli_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(flags + i)), 7);
+		bits |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(v))) << i;
+	}
+	return bits;
+#else
+	std::uint64_t bits = 0;
+	for (std::size_t i = 0; i < 64; ++i)
+		bits |= static_cast<std::uint64_t>(flags[i]) << i;
+	return bits;
+#endif
+}
+
+// Bit i is set iff the i-th object of size S at p is bytewise equal to key; count <= 64.
+template <std::size_t S>
+inline std::uint64_t match_mask(const unsigned char* p, std::size_t count, const unsigned char* key) noexcept
+{
+	assert(count <= 64);
+
+	std::uint64_t mask = 0;
+	std::size_t i = 0;
+
+#if defined(INPLACE_STRING_SSE2)
+	constexpr std::size_t width = simd_bytes::width;
+
+	if constexpr (S <= width && width % S == 0)
+	{
+		// several objects per register, compared against the key repeated width / S times
+		constexpr std::size_t per_register = width / S;
+		constexpr std::uint64_t object_bits = (std::uint64_t{1} << S) - 1;
+
+		unsigned char pattern[width];
+		for (std::size_t j = 0; j < width; ++j)
+			pattern[j] = key[j % S];
+
+		const simd_bytes::type k = simd_bytes::load(pattern);
+		for (; i + per_register <= count; i += per_register)
+		{
+			const std::uint64_t bytes = simd_bytes::equal(simd_bytes::load(p + i * S), k);
+			for (std::size_t j = 0; j < per_register; ++j)
+				mask |= static_cast<std::uint64_t>(((bytes >> (j * S)) & object_bits) == object_bits) << (i + j);
+		}
+	}
+	else if constexpr (S > width && S % width == 0)
+	{
+		// several registers per object
+		constexpr std::uint64_t register_bits = (std::uint64_t{1} << width) - 1;
+
+		for (; i < count; ++i)
+		{
+			std::uint64_t bytes = register_bits;
+			for (std::size_t j = 0; j < S; j += width)
+				bytes &= simd_bytes::equal(simd_bytes::load(p + i * S + j), simd_bytes::load(key + j));
+			mask |= static_cast<std::uint64_t>(bytes == register_bits) << i;
+		}
+	}
+#endif
+
+	for (; i < count; ++i)
+		mask |= static_cast<std::uint64_t>(std::memcmp(p + i * S, key, S) == 0) << i;
+
+	return mask;
+}
+
+}
+
+// Linear search of small tables of basic_inplace_string: as the characters past the terminator are zero, two strings are
+// equal iff their N + 1 characters are, and strings of 8, 16 or 32 bytes are compared by whole registers (e.g. 2
+// inplace_string<15> per AVX2 comparison), without looking at their size.
+
+// Bit i is set iff first[i] == key; requires last - first <= 64.
+template <std::size_t N, typename CharT, typename Traits>
+inline std::uint64_t match_mask(const basic_inplace_string<N, CharT, Traits>* first,
+								const basic_inplace_string<N, CharT, Traits>* last,
+								const basic_inplace_string<N, CharT, Traits>& key) noexcept
+{
+	using string = basic_inplace_string<N, CharT, Traits>;
+	static_assert(std::is_trivially_copyable<string>::value, "basic_inplace_string must be trivially copyable");
+
+	return detail::match_mask<sizeof(string)>(reinterpret_cast<const unsigned char*>(first),
+											  static_cast<std::size_t>(last - first),
+											  reinterpret_cast<const unsigned char*>(&key));
+}
+
+// First element of [first, last) equal to key, last if none.
+template <std::size_t N, typename CharT, typename Traits>
+inline const basic_inplace_string<N, CharT, Traits>* find_in(const basic_inplace_string<N, CharT, Traits>* first,
+															 const basic_inplace_string<N, CharT, Traits>* last,
+															 const basic_inplace_string<N, CharT, Traits>& key) noexcept
+{
+	while (first != last)
+	{
+		const auto* block_last = last - first > 64 ? first + 64 : last;
+		const std::uint64_t mask = match_mask(first, block_last, key);
+		if (mask != 0)
+			return first + detail::count_trailing_zeros(mask);
+
+		first = block_last;
+	}
+	return last;
+}
+
+namespace detail
+{
+
+// MSD radix sort on 8-bit digits: the N characters, then the size. As the characters past the terminator are zero, a
+// string orders before the strings it is a prefix of through its size.
+template <std::size_t N, typename Traits>
+struct radix_sort_impl
+{
+	using string = basic_inplace_string<N, char, Traits>;
+
+	static constexpr std::size_t comparison_sort_threshold = 64;
+	static constexpr std::size_t parallel_threshold = 16 * 1024;
+
+	struct task
+	{
+		string* first;
+		string* last;
+		std::size_t depth;
+	};
+
+	static std::size_t digit(const string& str, std::size_t depth) noexcept
+	{
+		return depth < N ? static_cast<unsigned char>(str.data()[depth]) : str.size();
+	}
+
+	// in-place partition on the digit at depth (American flag sort), calls spawn for each bucket to be sorted further
+	template <typename Spawn>
+	static void sort(string* first, string* last, std::size_t depth, Spawn& spawn)
+	{
+		const std::size_t size = static_cast<std::size_t>(last - first);
+
+		if (size < comparison_sort_threshold)
+		{
+			std::sort(first, last, [](const string& lhs, const string& rhs) { return lhs.compare(rhs) < 0; });
+			return;
+		}
+
+		std::array<std::size_t, 256> counts{};
+		for (const string* it = first; it != last; ++it)
+			++counts[digit(*it, depth)];
+
+		std::array<std::size_t, 257> bounds;
+		bounds[0] = 0;
+		for (std::size_t b = 0; b < 256; ++b)
+			bounds[b + 1] = bounds[b] + counts[b];
+
+		std::array<std::size_t, 256> next;
+		std::copy(bounds.begin(), bounds.end() - 1, next.begin());
+
+		for (std::size_t b = 0; b < 256; ++b)
+		{
+			while (next[b] < bounds[b + 1])
+			{
+				const std::size_t d = digit(first[next[b]], depth);
+				if (d == b)
+					++next[b];
+				else
+					std::swap(first[next[b]], first[next[d]++]);
+			}
+		}
+
+		// the digit at depth N is the size: all the strings of a bucket are equal
+		if (depth == N)
+			return;
+
+		for (std::size_t b = 0; b < 256; ++b)
+			if (counts[b] > 1)
+				spawn(first + bounds[b], first + bounds[b + 1], depth + 1);
+	}
+
+	static void sort(string* first, string* last)
+	{
+		auto recurse = [](string* f, string* l, std::size_t depth, auto& self) -> void
+		{
+			auto spawn = [&self](string* sf, string* sl, std::size_t d) { self(sf, sl, d, self); };
+			sort(f, l, depth, spawn);
+		};
+		recurse(first, last, 0, recurse);
+	}
+
+	// Buckets larger than parallel_threshold become tasks, pushed to the queue of the current worker; idle workers
+	// steal the oldest, hence largest, tasks of the others.
+	class parallel_sort
+	{
+	public:
+		explicit parallel_sort(unsigned threads)
+		{
+			for (unsigned i = 0; i < threads; ++i)
+				_workers.emplace_back(new worker);
+		}
+
+		void run(string* first, string* last)
+		{
+			push(0, task{first, last, 0});
+
+			std::vector<std::thread> threads;
+			for (std::size_t i = 1; i < _workers.size(); ++i)
+				threads.emplace_back([this, i]() { work(i); });
+
+			work(0);
+
+			for (std::thread& thread : threads)
+				thread.join();
+		}
+
+	private:
+		struct worker
+		{
+			std::mutex mutex;
+			std::deque<task> tasks;
+		};
+
+		void push(std::size_t id, const task& t)
+		{
+			_pending.fetch_add(1);
+
+			std::lock_guard<std::mutex> lock(_workers[id]->mutex);
+			_workers[id]->tasks.push_back(t);
+		}
+
+		bool pop(std::size_t id, task& t)
+		{
+			worker& w = *_workers[id];
+			std::lock_guard<std::mutex> lock(w.mutex);
+			if (w.tasks.empty())
+				return false;
+
+			t = w.tasks.back();
+			w.tasks.pop_back();
+			return true;
+		}
+
+		bool steal(std::size_t id, task& t)
+		{
+			for (std::size_t i = 1; i < _workers.size(); ++i)
+			{
+				worker& w = *_workers[(id + i) % _workers.size()];
+				std::lock_guard<std::mutex> lock(w.mutex);
+				if (!w.tasks.empty())
+				{
+					t = w.tasks.front();
+					w.tasks.pop_front();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void work(std::size_t id)
+		{
+			auto recurse = [this, id](string* f, string* l, std::size_t depth, auto& self) -> void
+			{
+				auto spawn = [this, id, &self](string* sf, string* sl, std::size_t d)
+				{
+					if (static_cast<std::size_t>(sl - sf) >= parallel_threshold)
+						push(id, task{sf, sl, d});
+					else
+						self(sf, sl, d, self);
+				};
+				radix_sort_impl::sort(f, l, depth, spawn);
+			};
+
+			while (_pending.load() != 0)
+			{
+				task t;
+				if (pop(id, t) || steal(id, t))
+				{
+					recurse(t.first, t.last, t.depth, recurse);
+					_pending.fetch_sub(1);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		std::vector<std::unique_ptr<worker>> _workers;
+		std::atomic<std::size_t> _pending{0};
+	};
+};
+
+}
+
+// Sorts [first, last) in the order of operator<, with a most-significant-digit radix sort reading the characters
+// directly, down to buckets of 64 strings which are sorted with std::sort. With threads > 1, the buckets are sorted in
+// parallel by a pool of work-stealing threads, the calling thread included.
+template <std::size_t N>
+inline void radix_sort(basic_inplace_string<N, char>* first, basic_inplace_string<N, char>* last, unsigned threads = 1)
+{
+	using impl = detail::radix_sort_impl<N, std::char_traits<char>>;
+
+	if (threads <= 1 || static_cast<std::size_t>(last - first) < impl::parallel_threshold)
+		impl::sort(first, last);
+	else
+	{
+		typename impl::parallel_sort sorter(threads);
+		sorter.run(first, last);
+	}
+}
+
+namespace detail
+{
+
+template <std::size_t N, typename Traits>
+inline void from_ordering_key(std::uint64_t key, basic_inplace_string<N, char, Traits>& str) noexcept
+{
+	const std::uint64_t v = to_big_endian(key ^ (std::uint64_t{0xff} << (8 * (7 - N))));
+	std::memcpy(static_cast<void*>(&str), &v, sizeof(str));
+}
+
+template <std::size_t N, typename Traits>
+inline void from_ordering_key(const std::array<std::uint64_t, 2>& key, basic_inplace_string<N, char, Traits>& str) noexcept
+{
+	const std::array<std::uint64_t, 2> v = {{to_big_endian(key[0]), to_big_endian(key[1] ^ (std::uint64_t{0xff} << (8 * (15 - N))))}};
+	std::memcpy(static_cast<void*>(&str), v.data(), sizeof(str));
+}
+
+template <typename T>
+inline void compare_exchange(T& a, T& b) noexcept
+{
+	const bool swap = b < a;
+	const T lo = swap ? b : a;
+	const T hi = swap ? a : b;
+	a = lo;
+	b = hi;
+}
+
+// Bitonic sorting network on P = 2^k elements, fully unrolled for a given P.
+template <std::size_t P, typename T>
+inline void bitonic_sort(T* a) noexcept
+{
+	for (std::size_t k = 2; k <= P; k <<= 1)
+		for (std::size_t j = k >> 1; j > 0; j >>= 1)
+			for (std::size_t i = 0; i < P; ++i)
+			{
+				const std::size_t l = i ^ j;
+				if (l > i)
+				{
+					if ((i & k) == 0)
+						compare_exchange(a[i], a[l]);
+					else
+						compare_exchange(a[l], a[i]);
+				}
+			}
+}
+
+template <typename T>
+inline void bitonic_sort(T* a, std::size_t p) noexcept
+{
+	switch (p)
+	{
+		case 1:  break;
+		case 2:  bitonic_sort<2>(a); break;
+		case 4:  bitonic_sort<4>(a); break;
+		case 8:  bitonic_sort<8>(a); break;
+		case 16: bitonic_sort<16>(a); break;
+		case 32: bitonic_sort<32>(a); break;
+		case 64: bitonic_sort<64>(a); break;
+		default: assert(false); break;
+	}
+}
+
+inline std::size_t network_size(std::size_t count) noexcept
+{
+	std::size_t p = 1;
+	while (p < count)
+		p <<= 1;
+	return p;
+}
+
+// The ordering key of the string (see inplace_string.h), or of the string and its index to sort stably
+template <std::size_t N>
+struct network_sort_traits
+{
+	using key_type = decltype(ordering_key(std::declval<const basic_inplace_string<N, char>&>(), fits_uint64<N, char>{}));
+
+	struct indexed_key
+	{
+		key_type key;
+		std::uint8_t index;
+
+		friend bool operator<(const indexed_key& lhs, const indexed_key& rhs) noexcept
+		{
+			return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.index < rhs.index);
+		}
+	};
+
+	static key_type max_key() noexcept
+	{
+		key_type key;
+		std::memset(&key, 0xff, sizeof(key));
+		return key;
+	}
+};
+
+}
+
+// Sorting networks for up to 64 strings of up to 16 bytes (inplace_string<7>, inplace_string<15>), e.g. the symbols of
+// an order book level. The strings are sorted as byte-swapped integers (see inplace_string_integer_less) with branch-free
+// compare-exchanges; the batch is padded to a power of two.
+
+template <std::size_t N>
+inline void network_sort(inplace_string<N>* first, inplace_string<N>* last) noexcept
+{
+	using traits = detail::network_sort_traits<N>;
+	using tag = detail::fits_uint64<N, char>;
+
+	const std::size_t count = static_cast<std::size_t>(last - first);
+	assert(count <= 64);
+
+	typename traits::key_type keys[64];
+	const std::size_t p = detail::network_size(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+		keys[i] = detail::ordering_key(first[i], tag{});
+	for (std::size_t i = count; i < p; ++i)
+		keys[i] = traits::max_key();
+
+	detail::bitonic_sort(keys, p);
+
+	for (std::size_t i = 0; i < count; ++i)
+		detail::from_ordering_key(keys[i], first[i]);
+}
+
+// Writes to indices the stable sorting permutation of [first, last): first[indices[0]] is the smallest string.
+template <std::size_t N>
+inline void network_sort_indices(const inplace_string<N>* first, const inplace_string<N>* last, std::uint8_t* indices) noexcept
+{
+	using traits = detail::network_sort_traits<N>;
+	using tag = detail::fits_uint64<N, char>;
+
+	const std::size_t count = static_cast<std::size_t>(last - first);
+	assert(count <= 64);
+
+	typename traits::indexed_key keys[64];
+	const std::size_t p = detail::network_size(count);
+
+	for (std::size_t i = 0; i < p; ++i)
+	{
+		keys[i].key = i < count ? detail::ordering_key(first[i], tag{}) : traits::max_key();
+		keys[i].index = static_cast<std::uint8_t>(i);
+	}
+
+	detail::bitonic_sort(keys, p);
+
+	for (std::size_t i = 0; i < count; ++i)
+		indices[i] = keys[i].index;
+}
+
+// Sorts [first, last) and removes the duplicates, returns the new end.
+template <std::size_t N>
+inline inplace_string<N>* network_sort_unique(inplace_string<N>* first, inplace_string<N>* last) noexcept
+{
+	network_sort(first, last);
+	return std::unique(first, last, inplace_string_integer_equal{});
+}
+
+namespace detail
+{
+
+// Hashes with inplace_string_integer_hash in groups of 8 strings: each round of mix_uint64 is applied to the whole
+// group before the next one, so that the multiplications of independent strings overlap in the pipeline (or share a
+// vector register when 64-bit multiplications are available, e.g. with AVX-512).
+template <std::size_t N, typename CharT, typename Traits>
+inline void hash_batch(const basic_inplace_string<N, CharT, Traits>* first, std::size_t count, std::size_t* out,
+					   const inplace_string_integer_hash&) noexcept
+{
+	static const std::size_t lanes = 8;
+	using tag = fits_uint64<N, CharT>;
+
+	std::size_t i = 0;
+	for (; i + lanes <= count; i += lanes)
+	{
+		std::uint64_t v[lanes];
+		for (std::size_t l = 0; l < lanes; ++l)
+			v[l] = integer_hash_input(first[i + l], tag{});
+
+		for (std::size_t l = 0; l < lanes; ++l) v[l] ^= v[l] >> 33;
+		for (std::size_t l = 0; l < lanes; ++l) v[l] *= 0xff51afd7ed558ccdULL;
+		for (std::size_t l = 0; l < lanes; ++l) v[l] ^= v[l] >> 33;
+		for (std::size_t l = 0; l < lanes; ++l) v[l] *= 0xc4ceb9fe1a85ec53ULL;
+		for (std::size_t l = 0; l < lanes; ++l) v[l] ^= v[l] >> 33;
+
+		for (std::size_t l = 0; l < lanes; ++l)
+			out[i + l] = static_cast<std::size_t>(v[l]);
+	}
+
+	for (; i < count; ++i)
+		out[i] = mix_uint64(integer_hash_input(first[i], tag{}));
+}
+
+// Any other hasher, e.g. std::hash: the calls are independent and overlap as far as the hasher allows
+template <std::size_t N, typename CharT, typename Traits, typename Hash>
+inline void hash_batch(const basic_inplace_string<N, CharT, Traits>* first, std::size_t count, std::size_t* out, const Hash& hash)
+{
+	for (std::size_t i = 0; i < count; ++i)
+		out[i] = hash(first[i]);
+}
+
+}
+
+// Writes hash(first[i]) to out[i] for each string of [first, last): the values are those of Hash. With
+// inplace_string_integer_hash, the strings are hashed in interleaved groups of 8.
+template <std::size_t N, typename CharT, typename Traits, typename Hash = std::hash<basic_inplace_string<N, CharT, Traits>>>
+inline void hash_batch(const basic_inplace_string<N, CharT, Traits>* first,
+					   const basic_inplace_string<N, CharT, Traits>* last,
+					   std::size_t* out,
+					   const Hash& hash = Hash())
+{
+	detail::hash_batch(first, static_cast<std::size_t>(last - first), out, hash);
+}
+
+// Writes lhs_first[i] == rhs_first[i] to out[i] for each string of [lhs_first, lhs_last), e.g. to check the candidates
+// found by probing a hash table. As the characters past the terminator are zero, each pair is compared with a single
+// memcmp of the N + 1 characters, inlined as a few word comparisons.
+template <std::size_t N, typename CharT, typename Traits>
+inline void equal_batch(const basic_inplace_string<N, CharT, Traits>* lhs_first,
+						const basic_inplace_string<N, CharT, Traits>* lhs_last,
+						const basic_inplace_string<N, CharT, Traits>* rhs_first,
+						std::uint8_t* out) noexcept
+{
+	using string_type = basic_inplace_string<N, CharT, Traits>;
+
+	const std::size_t count = static_cast<std::size_t>(lhs_last - lhs_first);
+	for (std::size_t i = 0; i < count; ++i)
+		out[i] = static_cast<std::uint8_t>(std::memcmp(lhs_first + i, rhs_first + i, sizeof(string_type)) == 0);
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <initializer_list>
+#include <iterator>
+#include <vector>
+
+// Struct-of-arrays counterpart of std::vector<basic_inplace_string<N>>: the characters of row i are stored at
+// chars() + i * N, zero-padded like in basic_inplace_string, and the sizes in a separate dense array of bytes. Scans
+// over the sizes or over the first characters of each row then only touch the bytes they need.
+template <
+	std::size_t N,
+	typename CharT = char,
+	typename Traits = std::char_traits<CharT>>
+class basic_inplace_string_column
+{
+public:
+	static_assert(N > 0 && N <= 255, "basic_inplace_string_column: sizes are stored on 8 bits");
+
+	using string_type = basic_inplace_string<N, CharT, Traits>;
+	using view_type = basic_string_view<CharT, Traits>;
+	using value_type = view_type;
+	using size_type = std::size_t;
+
+	class const_iterator;
+
+	basic_inplace_string_column() = default;
+
+	template <typename InputIt, typename X = typename std::enable_if<detail::is_input_iterator<InputIt>::value>::type>
+	basic_inplace_string_column(InputIt first, InputIt last);
+
+	basic_inplace_string_column(std::initializer_list<view_type> ilist) : basic_inplace_string_column(ilist.begin(), ilist.end()) {}
+
+	// The returned views stay valid until the column is modified.
+	view_type operator[](size_type i) const noexcept { assert(i < size()); return {row(i), _sizes[i]}; }
+	view_type at(size_type i) const;
+
+	string_type get(size_type i) const;
+	void set(size_type i, view_type sv);
+
+	const_iterator begin() const noexcept;
+	const_iterator end() const noexcept;
+
+	const CharT* chars() const noexcept { return _chars.data(); }
+	const std::uint8_t* sizes() const noexcept { return _sizes.data(); }
+
+	const CharT* row(size_type i) const noexcept { return _chars.data() + i * N; }
+
+	size_type size() const noexcept { return _sizes.size(); }
+	bool empty() const noexcept     { return _sizes.empty(); }
+
+	void reserve(size_type new_cap);
+	void clear() noexcept;
+	void push_back(view_type sv);
+	void pop_back();
+
+	// out[i] = 1 if the size of row i is within [min_size, max_size], 0 otherwise. Reads the size array only.
+	void size_between(size_type min_size, size_type max_size, std::uint8_t* out) const noexcept;
+
+	// out[i] = 1 if row i starts with prefix, 0 otherwise. Reads the first prefix.size() characters of each row only.
+	void starts_with(view_type prefix, std::uint8_t* out) const noexcept;
+
+private:
+	static void check_size(size_type sz);
+
+	std::vector<CharT> _chars;
+	std::vector<std::uint8_t> _sizes;
+};
+
+template <std::size_t N, typename CharT, typename Traits>
+class basic_inplace_string_column<N, CharT, Traits>::const_iterator
+{
+public:
+	using iterator_category = std::random_access_iterator_tag;
+	using value_type = view_type;
+	using difference_type = std::ptrdiff_t;
+	using pointer = void;
+	using reference = view_type;
+
+	const_iterator() = default;
+
+	reference operator*() const noexcept { return (*_column)[_index]; }
+	reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+	const_iterator& operator++() noexcept { ++_index; return *this; }
+	const_iterator& operator--() noexcept { --_index; return *this; }
+	const_iterator operator++(int) noexcept { const_iterator it = *this; ++_index; return it; }
+	const_iterator operator--(int) noexcept { const_iterator it = *this; --_index; return it; }
+
+	const_iterator& operator+=(difference_type n) noexcept { _index = static_cast<size_type>(static_cast<difference_type>(_index) + n); return *this; }
+	const_iterator& operator-=(difference_type n) noexcept { return *this += -n; }
+
+	friend const_iterator operator+(const_iterator it, difference_type n) noexcept { return it += n; }
+	friend const_iterator operator+(difference_type n, const_iterator it) noexcept { return it += n; }
+	friend const_iterator operator-(const_iterator it, difference_type n) noexcept { return it -= n; }
+	friend difference_type operator-(const const_iterator& lhs, const const_iterator& rhs) noexcept
+	{
+		return static_cast<difference_type>(lhs._index) - static_cast<difference_type>(rhs._index);
+	}
+
+	friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) noexcept { return lhs._index == rhs._index; }
+	friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) noexcept { return lhs._index != rhs._index; }
+	friend bool operator<(const const_iterator& lhs, const const_iterator& rhs) noexcept  { return lhs._index < rhs._index; }
+	friend bool operator>(const const_iterator& lhs, const const_iterator& rhs) noexcept  { return lhs._index > rhs._index; }
+	friend bool operator<=(const const_iterator& lhs, const const_iterator& rhs) noexcept { return lhs._index <= rhs._index; }
+	friend bool operator>=(const const_iterator& lhs, const const_iterator& rhs) noexcept { return lhs._index >= rhs._index; }
+
+private:
+	friend class basic_inplace_string_column;
+
+	const_iterator(const basic_inplace_string_column* column, size_type index) noexcept :
+		_column(column),
+		_index(index)
+	{}
+
+	const basic_inplace_string_column* _column = nullptr;
+	size_type _index = 0;
+};
+
+template <std::size_t N, typename CharT, typename Traits>
+template <typename InputIt, typename X>
+basic_inplace_string_column<N, CharT, Traits>::basic_inplace_string_column(InputIt first, InputIt last)
+{
+	if (detail::is_forward_iterator<InputIt>::value)
+		reserve(static_cast<size_type>(std::distance(first, last)));
+
+	for (; first != last; ++first)
+		push_back(view_type(*first));
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_column<N, CharT, Traits>::check_size(size_type sz)
+{
+	if (sz > N)
+		detail::throw_helper<std::length_error>("basic_inplace_string_column: exceed maximum string length");
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_inplace_string_column<N, CharT, Traits>::view_type
+basic_inplace_string_column<N, CharT, Traits>::at(size_type i) const
+{
+	if (i >= size())
+		detail::throw_helper<std::out_of_range>("basic_inplace_string_column::at: out of range");
+
+	return (*this)[i];
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_inplace_string_column<N, CharT, Traits>::string_type
+basic_inplace_string_column<N, CharT, Traits>::get(size_type i) const
+{
+	assert(i < size());
+
+	return string_type(row(i), _sizes[i]);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_column<N, CharT, Traits>::set(size_type i, view_type sv)
+{
+	assert(i < size());
+	check_size(sv.size());
+
+	CharT* p = _chars.data() + i * N;
+	Traits::copy(p, sv.data(), sv.size());
+	Traits::assign(p + sv.size(), N - sv.size(), CharT{});
+	_sizes[i] = static_cast<std::uint8_t>(sv.size());
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_inplace_string_column<N, CharT, Traits>::const_iterator
+basic_inplace_string_column<N, CharT, Traits>::begin() const noexcept
+{
+	return const_iterator(this, 0);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_inplace_string_column<N, CharT, Traits>::const_iterator
+basic_inplace_string_column<N, CharT, Traits>::end() const noexcept
+{
+	return const_iterator(this, size());
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_column<N, CharT, Traits>::reserve(size_type new_cap)
+{
+	_chars.reserve(new_cap * N);
+	_sizes.reserve(new_cap);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_column<N, CharT, Traits>::clear() noexcept
+{
+	_chars.clear();
+	_sizes.clear();
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_column<N, CharT, Traits>::push_back(view_type sv)
+{
+	check_size(sv.size());
+
+	_chars.insert(_chars.end(), sv.begin(), sv.end());
+	_chars.resize(_chars.size() + N - sv.size(), CharT{});
+	_sizes.push_back(static_cast<std::uint8_t>(sv.size()));
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_column<N, CharT, Traits>::pop_back()
+{
+	assert(!empty());
+
+	_chars.resize(_chars.size() - N);
+	_sizes.pop_back();
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_column<N, CharT, Traits>::size_between(size_type min_size, size_type max_size, std::uint8_t* out) const noexcept
+{
+	const std::uint8_t* sizes = _sizes.data();
+	const std::size_t n = _sizes.size();
+
+	if (min_size > max_size || min_size > N)
+	{
+		std::fill(out, out + n, std::uint8_t{0});
+		return;
+	}
+
+	const std::uint8_t lo = static_cast<std::uint8_t>(min_size);
+	const std::uint8_t range = static_cast<std::uint8_t>(std::min<size_type>(max_size, N) - min_size);
+
+	// a single unsigned comparison per row, vectorized by the compiler
+	for (std::size_t i = 0; i < n; ++i)
+		out[i] = static_cast<std::uint8_t>(static_cast<std::uint8_t>(sizes[i] - lo) <= range);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_column<N, CharT, Traits>::starts_with(view_type prefix, std::uint8_t* out) const noexcept
+{
+	const std::size_t n = _sizes.size();
+
+	if (prefix.size() > N)
+	{
+		std::fill(out, out + n, std::uint8_t{0});
+		return;
+	}
+
+	const CharT* p = _chars.data();
+	for (std::size_t i = 0; i < n; ++i, p += N)
+		out[i] = static_cast<std::uint8_t>(_sizes[i] >= prefix.size() && Traits::compare(p, prefix.data(), prefix.size()) == 0);
+}
+
+template <std::size_t N> using inplace_string_column = basic_inplace_string_column<N, char>;
@@ -0,0 +1,412 @@
+#pragma once
+
+#include "inplace_string_algorithm.h"
+#include "inplace_string_file.h"
+#include "inplace_string_vector.h"
+
+#include <tuple>
+
+// Reader of CSV or TSV files into columns of basic_inplace_string, one capacity per column:
+//
+//   csv_options options;
+//   options.threads = 8;
+//   const csv_table<15, 3, 31> instruments = read_csv<15, 3, 31>("instruments.csv", options);
+//   const inplace_string_vector<15>& symbols = instruments.column<0>();
+//
+// The file is mapped in memory and split into one chunk per thread at record boundaries; the chunks are parsed in
+// parallel, and their columns concatenated. Delimiters, quotes and line ends are located 16 or 32 bytes at a time with
+// SSE2/AVX2. Fields are copied from the mapped file into the columns, except quoted fields holding escaped quotes ("")
+// which are unescaped first.
+//
+// Records end with "\n" or "\r\n", and empty lines are skipped. Quoted fields may hold delimiters and line ends. Missing
+// fields are empty, extra fields are ignored. A field longer than the capacity of its column is cut to the capacity and
+// reported in overflows(), with its row and column. The chunks are split on the parity of the number of quotes, which
+// assumes that quotes only appear around fields or escaped in quoted fields.
+
+struct csv_options
+{
+	char delimiter = ',';
+	char quote = '"';
+	bool header = true;   // the first record holds the column names
+	unsigned threads = 1; // the calling thread included
+};
+
+// Field cut to the capacity of its column. row is the position of the record in the columns, header excluded.
+struct csv_overflow
+{
+	std::size_t row;
+	std::size_t column;
+	std::size_t size;
+};
+
+inline bool operator==(const csv_overflow& lhs, const csv_overflow& rhs) noexcept
+{
+	return lhs.row == rhs.row && lhs.column == rhs.column && lhs.size == rhs.size;
+}
+
+template <std::size_t... N>
+class csv_table;
+
+template <std::size_t... N>
+csv_table<N...> parse_csv(const char* data, std::size_t size, const csv_options& options = csv_options());
+
+namespace detail
+{
+
+// Chunks of at least this size are parsed on their own thread
+constexpr std::size_t csv_min_chunk_size = 1 << 16;
+
+// Locates the delimiters, quotes and line ends
+class csv_scanner
+{
+public:
+	csv_scanner(char delimiter, char quote) noexcept :
+		_delimiter(delimiter),
+		_quote(quote)
+	{
+#if defined(INPLACE_STRING_SSE2)
+		_delimiters = broadcast(delimiter);
+		_quotes = broadcast(quote);
+		_lfs = broadcast('\n');
+		_crs = broadcast('\r');
+#endif
+	}
+
+	// First delimiter, quote, '\n' or '\r' in [p, end), end if none
+	const char* find(const char* p, const char* end) const noexcept
+	{
+#if defined(INPLACE_STRING_SSE2)
+		for (; end - p >= static_cast<std::ptrdiff_t>(simd_bytes::width); p += simd_bytes::width)
+		{
+			const simd_bytes::type v = simd_bytes::load(reinterpret_cast<const unsigned char*>(p));
+			const std::uint64_t mask = simd_bytes::equal(v, _delimiters) | simd_bytes::equal(v, _quotes) |
+									   simd_bytes::equal(v, _lfs) | simd_bytes::equal(v, _crs);
+			if (mask != 0)
+				return p + count_trailing_zeros(mask);
+		}
+#endif
+		for (; p != end; ++p)
+			if (*p == _delimiter || *p == _quote || *p == '\n' || *p == '\r')
+				return p;
+		return end;
+	}
+
+	// Whether [p, end) holds an odd number of quotes
+	bool odd_quotes(const char* p, const char* end) const noexcept
+	{
+		std::uint64_t parity = 0;
+#if defined(INPLACE_STRING_SSE2)
+		for (; end - p >= static_cast<std::ptrdiff_t>(simd_bytes::width); p += simd_bytes::width)
+			parity ^= simd_bytes::equal(simd_bytes::load(reinterpret_cast<const unsigned char*>(p)), _quotes);
+
+		for (unsigned shift = 32; shift != 0; shift /= 2)
+			parity ^= parity >> shift;
+		parity &= 1;
+#endif
+		for (; p != end; ++p)
+			parity ^= *p == _quote;
+		return parity != 0;
+	}
+
+	char delimiter() const noexcept { return _delimiter; }
+	char quote() const noexcept     { return _quote; }
+
+private:
+#if defined(INPLACE_STRING_SSE2)
+	static simd_bytes::type broadcast(char c) noexcept
+	{
+		unsigned char pattern[simd_bytes::width];
+		std::memset(pattern, c, sizeof(pattern));
+		return simd_bytes::load(pattern);
+	}
+
+	simd_bytes::type _delimiters;
+	simd_bytes::type _quotes;
+	simd_bytes::type _lfs;
+	simd_bytes::type _crs;
+#endif
+	char _delimiter;
+	char _quote;
+};
+
+// Parses the record at p, not empty, calling field(column, view) for each of its fields. Returns the start of the next
+// record. buffer holds the unescaped quoted fields.
+template <typename Field>
+const char* parse_csv_record(const csv_scanner& scanner, const char* p, const char* end, std::string& buffer, Field&& field)
+{
+	const char quote = scanner.quote();
+
+	for (std::size_t column = 0;; ++column)
+	{
+		const char* first = p;
+		const char* last = p;
+		bool unescaped = false; // the field is in the buffer
+
+		if (p != end && *p == quote)
+		{
+			// quoted field: copied to the buffer only if it holds escaped quotes
+			first = ++p;
+			for (;;)
+			{
+				const void* q = std::memchr(p, quote, static_cast<std::size_t>(end - p));
+				last = q != nullptr ? static_cast<const char*>(q) : end;
+
+				if (last == end || last + 1 == end || last[1] != quote)
+					break;
+
+				if (!unescaped)
+					buffer.clear();
+				buffer.append(p, last + 1);
+				unescaped = true;
+				p = last + 2;
+			}
+
+			if (unescaped)
+				buffer.append(p, last);
+			p = last == end ? end : last + 1;
+		}
+
+		// unquoted field, or characters after the closing quote
+		const char* const rest = p;
+		for (;;)
+		{
+			p = scanner.find(p, end);
+			if (p == end || *p == scanner.delimiter() || *p == '\n' || (*p == '\r' && p + 1 != end && p[1] == '\n'))
+				break;
+			++p; // quote or lone '\r' within the field
+		}
+
+		if (first == rest)
+		{
+			last = p;
+		}
+		else if (rest != p)
+		{
+			if (!unescaped)
+				buffer.assign(first, last);
+			buffer.append(rest, p);
+			unescaped = true;
+		}
+
+		if (unescaped)
+			field(column, basic_string_view<char, std::char_traits<char>>(buffer.data(), buffer.size()));
+		else
+			field(column, basic_string_view<char, std::char_traits<char>>(first, static_cast<std::size_t>(last - first)));
+
+		if (p == end)
+			return end;
+		if (*p == scanner.delimiter())
+		{
+			++p;
+			continue;
+		}
+		return p + (*p == '\r' ? 2 : 1);
+	}
+}
+
+// Start of the first non-empty record in [p, end)
+inline const char* skip_csv_empty_lines(const char* p, const char* end) noexcept
+{
+	while (p != end && (*p == '\n' || (*p == '\r' && p + 1 != end && p[1] == '\n')))
+		p += *p == '\r' ? 2 : 1;
+	return p;
+}
+
+// Runs f(i) for i in [0, count), on count - 1 threads and the calling thread
+template <typename F>
+void run_csv_tasks(std::size_t count, F&& f)
+{
+	std::vector<std::thread> threads;
+	for (std::size_t i = 1; i < count; ++i)
+		threads.emplace_back([&f, i]() { f(i); });
+
+	f(0);
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+}
+
+template <std::size_t... N>
+class csv_table
+{
+public:
+	using columns_type = std::tuple<inplace_string_vector<N>...>;
+
+	static constexpr std::size_t column_count = sizeof...(N);
+
+	std::size_t rows() const noexcept { return _rows; }
+
+	template <std::size_t I>
+	const typename std::tuple_element<I, columns_type>::type& column() const noexcept { return std::get<I>(_columns); }
+
+	// Column names, empty without header
+	const std::vector<std::string>& header() const noexcept { return _header; }
+
+	// Fields cut to the capacity of their column, by row
+	const std::vector<csv_overflow>& overflows() const noexcept { return _overflows; }
+
+private:
+	template <std::size_t... M>
+	friend csv_table<M...> parse_csv(const char* data, std::size_t size, const csv_options& options);
+
+	// Appends the records of [p, end)
+	void parse(const detail::csv_scanner& scanner, const char* p, const char* end);
+
+	template <std::size_t I>
+	void push(basic_string_view<char, std::char_traits<char>> field)
+	{
+		constexpr std::size_t capacity = std::tuple_element<I, columns_type>::type::value_type::max_size();
+
+		std::size_t size = field.size();
+		if (size > capacity)
+		{
+			_overflows.push_back(csv_overflow{_rows, I, size});
+			size = capacity;
+		}
+		std::get<I>(_columns).emplace_back(field.data(), size);
+	}
+
+	template <std::size_t... I>
+	void push(std::size_t column, basic_string_view<char, std::char_traits<char>> field, std::index_sequence<I...>)
+	{
+		static_cast<void>(((column == I ? (push<I>(field), true) : false) || ...));
+	}
+
+	// Completes the record with empty fields
+	template <std::size_t... I>
+	void complete(std::size_t fields, std::index_sequence<I...>)
+	{
+		static_cast<void>(((I >= fields ? (std::get<I>(_columns).emplace_back(), true) : false), ...));
+	}
+
+	// Appends the rows of other, parsed after this
+	template <std::size_t... I>
+	void append(csv_table& other, std::index_sequence<I...>);
+
+	columns_type _columns;
+	std::size_t _rows = 0;
+	std::vector<std::string> _header;
+	std::vector<csv_overflow> _overflows;
+};
+
+template <std::size_t... N>
+void csv_table<N...>::parse(const detail::csv_scanner& scanner, const char* p, const char* end)
+{
+	std::string buffer;
+
+	for (p = detail::skip_csv_empty_lines(p, end); p != end; p = detail::skip_csv_empty_lines(p, end))
+	{
+		std::size_t fields = 0;
+		p = detail::parse_csv_record(scanner, p, end, buffer, [&](std::size_t column, basic_string_view<char, std::char_traits<char>> field)
+		{
+			push(column, field, std::make_index_sequence<sizeof...(N)>{});
+			fields = column + 1;
+		});
+
+		complete(fields, std::make_index_sequence<sizeof...(N)>{});
+		++_rows;
+	}
+}
+
+template <std::size_t... N>
+template <std::size_t... I>
+void csv_table<N...>::append(csv_table& other, std::index_sequence<I...>)
+{
+	auto append_column = [](auto& column, const auto& other_column)
+	{
+		const std::size_t size = column.size();
+		column.resize_uninitialized(size + other_column.size());
+		if (!other_column.empty())
+			std::memcpy(static_cast<void*>(column.data() + size), other_column.data(), other_column.size() * sizeof(other_column[0]));
+	};
+	static_cast<void>((append_column(std::get<I>(_columns), std::get<I>(other._columns)), ...));
+
+	for (const csv_overflow& overflow : other._overflows)
+		_overflows.push_back(csv_overflow{_rows + overflow.row, overflow.column, overflow.size});
+	_rows += other._rows;
+}
+
+// Parses the CSV records of [data, data + size), on options.threads threads for large inputs
+template <std::size_t... N>
+csv_table<N...> parse_csv(const char* data, std::size_t size, const csv_options& options)
+{
+	static_assert(sizeof...(N) > 0, "parse_csv: no column");
+
+	const detail::csv_scanner scanner(options.delimiter, options.quote);
+	const char* p = data;
+	const char* const end = data + size;
+
+	csv_table<N...> table;
+	if (options.header)
+	{
+		std::string buffer;
+		p = detail::skip_csv_empty_lines(p, end);
+		if (p != end)
+		{
+			p = detail::parse_csv_record(scanner, p, end, buffer, [&](std::size_t, basic_string_view<char, std::char_traits<char>> field)
+			{
+				table._header.emplace_back(field.data(), field.size());
+			});
+		}
+	}
+
+	const std::size_t bytes = static_cast<std::size_t>(end - p);
+	std::size_t chunks = bytes / detail::csv_min_chunk_size;
+	chunks = std::max<std::size_t>(1, std::min<std::size_t>(chunks, options.threads));
+
+	if (chunks == 1)
+	{
+		table.parse(scanner, p, end);
+		return table;
+	}
+
+	// a chunk boundary is in a quoted field iff the number of quotes before it is odd
+	std::vector<const char*> bounds(chunks + 1);
+	for (std::size_t i = 0; i < chunks; ++i)
+		bounds[i] = p + bytes / chunks * i;
+	bounds[chunks] = end;
+
+	std::vector<char> odd(chunks);
+	detail::run_csv_tasks(chunks, [&](std::size_t i) { odd[i] = scanner.odd_quotes(bounds[i], bounds[i + 1]); });
+
+	// moves each boundary past the end of its record
+	bool quoted = false;
+	for (std::size_t i = 1; i < chunks; ++i)
+	{
+		quoted ^= odd[i - 1] != 0;
+
+		const char* b = end;
+		bool in_quotes = quoted;
+		for (const char* q = bounds[i]; q != end; ++q)
+		{
+			if (*q == options.quote)
+			{
+				in_quotes = !in_quotes;
+			}
+			else if (*q == '\n' && !in_quotes)
+			{
+				b = q + 1;
+				break;
+			}
+		}
+		bounds[i] = std::max(b, bounds[i - 1]);
+	}
+
+	std::vector<csv_table<N...>> parts(chunks);
+	detail::run_csv_tasks(chunks, [&](std::size_t i) { parts[i].parse(scanner, bounds[i], bounds[i + 1]); });
+
+	for (csv_table<N...>& part : parts)
+		table.append(part, std::make_index_sequence<sizeof...(N)>{});
+	return table;
+}
+
+// Maps the file and parses it. Throws std::runtime_error if the file cannot be mapped.
+template <std::size_t... N>
+csv_table<N...> read_csv(const std::string& path, const csv_options& options = csv_options())
+{
+	// an empty file, left unmapped, is an empty table
+	const detail::mapped_file file(path, true);
+	return parse_csv<N...>(reinterpret_cast<const char*>(file.data()), file.size(), options);
+}
@@ -0,0 +1,530 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <fstream>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// File format for arrays of basic_inplace_string, mapped in memory and used in place:
+//
+//   header                          inplace_string_file_header, padded to 128 bytes
+//   keys        at 128              count strings of N + 1 characters, as in memory
+//   values      at values_offset    count values of value_size bytes (none for plain string tables)
+//   index       at index_offset     index_slots 64-bit slots: open addressing on the hash of the keys, each slot holding
+//                                   the position of a key plus one, 0 if empty
+//
+// The sections are aligned on 64 bytes. Files are written in the byte order and layout of the writer, which the
+// layout checksum identifies.
+struct inplace_string_file_header
+{
+	static constexpr const char magic_value[8] = {'I', 'P', 'S', 'T', 'R', 'I', 'N', 'G'};
+	static constexpr std::uint32_t current_version = 1;
+	static constexpr std::uint64_t alignment = 64;
+
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t char_size;
+	std::uint64_t capacity;        // N
+	std::uint64_t layout_checksum;
+	std::uint64_t count;
+	std::uint64_t value_size;
+	std::uint64_t values_offset;   // 0 if no values
+	std::uint64_t index_offset;    // 0 if no index
+	std::uint64_t index_slots;
+};
+
+namespace detail
+{
+
+constexpr std::uint64_t file_header_size = 128;
+
+// N of a basic_inplace_string
+template <typename String>
+constexpr std::uint64_t file_capacity() noexcept
+{
+	return sizeof(String) / sizeof(typename String::value_type) - 1;
+}
+
+static_assert(sizeof(inplace_string_file_header) <= file_header_size, "inplace_string_file_header: exceeds the header size");
+
+inline std::uint64_t align_file_offset(std::uint64_t offset) noexcept
+{
+	const std::uint64_t a = inplace_string_file_header::alignment;
+	return (offset + a - 1) / a * a;
+}
+
+// Identifies the layout of the strings and of the hash: size of the string, of its characters and of size_t, byte order
+template <typename String>
+inline std::uint64_t file_layout_checksum(std::uint64_t value_size) noexcept
+{
+	const std::uint64_t byte_order = 0x0102030405060708ULL;
+	unsigned char first_byte;
+	std::memcpy(&first_byte, &byte_order, 1);
+
+	return mix_uint64(sizeof(String)
+					  ^ (std::uint64_t{sizeof(typename String::value_type)} << 16)
+					  ^ (std::uint64_t{sizeof(std::size_t)} << 24)
+					  ^ (std::uint64_t{first_byte} << 28)
+					  ^ (value_size << 32));
+}
+
+// Hash of the keys of the index. It must not change between the writer and the readers: strings of up to 16 bytes are
+// hashed with inplace_string_integer_hash, longer ones as a sequence of 64-bit words.
+template <typename String>
+inline std::size_t file_hash(const String& str, std::true_type) noexcept
+{
+	return inplace_string_integer_hash()(str);
+}
+
+template <typename String>
+inline std::size_t file_hash(const String& str, std::false_type) noexcept
+{
+	// the characters past the terminator are zero: the whole object can be hashed
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(&str);
+	std::uint64_t h = 0;
+
+	for (std::size_t i = 0; i < sizeof(String); i += sizeof(std::uint64_t))
+	{
+		std::uint64_t w = 0;
+		std::memcpy(&w, p + i, std::min(sizeof(w), sizeof(String) - i));
+		h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+		h ^= h >> 29;
+	}
+	return mix_uint64(h);
+}
+
+template <typename String>
+inline std::size_t file_hash(const String& str) noexcept
+{
+	return file_hash(str, std::integral_constant<bool, sizeof(String) <= 2 * sizeof(std::uint64_t)>{});
+}
+
+// Read-only mapping of a whole file. An empty file is an error, unless allow_empty: it is then left unmapped, with a
+// null data() and a size() of 0.
+class mapped_file
+{
+public:
+	mapped_file() = default;
+	explicit mapped_file(const std::string& path, bool allow_empty = false);
+	~mapped_file() { unmap(); }
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	mapped_file(mapped_file&& other) noexcept { swap(other); }
+	mapped_file& operator=(mapped_file&& other) noexcept { swap(other); return *this; }
+
+	const unsigned char* data() const noexcept { return _data; }
+	std::size_t size() const noexcept          { return _size; }
+
+	void swap(mapped_file& other) noexcept
+	{
+		std::swap(_data, other._data);
+		std::swap(_size, other._size);
+	}
+
+private:
+	void unmap() noexcept;
+
+	const unsigned char* _data = nullptr;
+	std::size_t _size = 0;
+};
+
+#if defined(_WIN32)
+
+inline mapped_file::mapped_file(const std::string& path, bool allow_empty)
+{
+	HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw_helper<std::runtime_error>("mapped_file: cannot open " + path);
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(file, &size) || (size.QuadPart == 0 && !allow_empty))
+	{
+		::CloseHandle(file);
+		throw_helper<std::runtime_error>("mapped_file: cannot map " + path);
+	}
+	if (size.QuadPart == 0)
+	{
+		::CloseHandle(file);
+		return;
+	}
+
+	HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	::CloseHandle(file);
+	if (mapping == nullptr)
+		throw_helper<std::runtime_error>("mapped_file: cannot map " + path);
+
+	const void* p = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	::CloseHandle(mapping);
+	if (p == nullptr)
+		throw_helper<std::runtime_error>("mapped_file: cannot map " + path);
+
+	_data = static_cast<const unsigned char*>(p);
+	_size = static_cast<std::size_t>(size.QuadPart);
+}
+
+inline void mapped_file::unmap() noexcept
+{
+	if (_data != nullptr)
+		::UnmapViewOfFile(_data);
+}
+
+#else
+
+inline mapped_file::mapped_file(const std::string& path, bool allow_empty)
+{
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		throw_helper<std::runtime_error>("mapped_file: cannot open " + path);
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || st.st_size < 0 || (st.st_size == 0 && !allow_empty))
+	{
+		::close(fd);
+		throw_helper<std::runtime_error>("mapped_file: cannot map " + path);
+	}
+	if (st.st_size == 0)
+	{
+		::close(fd);
+		return;
+	}
+
+	const std::size_t size = static_cast<std::size_t>(st.st_size);
+	void* p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED)
+		throw_helper<std::runtime_error>("mapped_file: cannot map " + path);
+
+	_data = static_cast<const unsigned char*>(p);
+	_size = size;
+}
+
+inline void mapped_file::unmap() noexcept
+{
+	if (_data != nullptr)
+		::munmap(const_cast<unsigned char*>(_data), _size);
+}
+
+#endif
+
+// Open-addressing slots of the keys: a power of two at least twice the number of keys, linear probing
+template <typename String>
+inline std::vector<std::uint64_t> build_file_index(const String* keys, std::size_t count)
+{
+	std::size_t slots = 1;
+	while (slots < 2 * count)
+		slots *= 2;
+
+	std::vector<std::uint64_t> index(slots);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		std::size_t s = file_hash(keys[i]) & (slots - 1);
+		while (index[s] != 0)
+			s = (s + 1) & (slots - 1);
+		index[s] = i + 1;
+	}
+	return index;
+}
+
+// Position of key in keys, count if not found
+template <typename String>
+inline std::size_t find_in_file_index(const std::uint64_t* index, std::size_t slots, const String* keys, std::size_t count,
+									  const String& key) noexcept
+{
+	if (slots == 0)
+		return count;
+
+	std::size_t s = file_hash(key) & (slots - 1);
+	for (std::size_t probes = 0; probes < slots; ++probes)
+	{
+		const std::uint64_t entry = index[s];
+		if (entry == 0 || entry > count)
+			return count;
+		if (keys[entry - 1] == key)
+			return static_cast<std::size_t>(entry - 1);
+		s = (s + 1) & (slots - 1);
+	}
+	return count;
+}
+
+template <typename String>
+inline void write_file(const std::string& path, const String* keys, std::size_t count, const void* values, std::size_t value_size,
+					   bool with_index)
+{
+	static_assert(inplace_string_layout<String>::value, "write_file: unexpected string layout");
+
+	std::vector<std::uint64_t> index;
+	if (with_index)
+		index = build_file_index(keys, count);
+
+	inplace_string_file_header header = {};
+	std::memcpy(header.magic, inplace_string_file_header::magic_value, sizeof(header.magic));
+	header.version = inplace_string_file_header::current_version;
+	header.char_size = sizeof(typename String::value_type);
+	header.capacity = file_capacity<String>();
+	header.layout_checksum = file_layout_checksum<String>(value_size);
+	header.count = count;
+	header.value_size = value_size;
+
+	std::uint64_t offset = align_file_offset(file_header_size + count * sizeof(String));
+	if (value_size > 0)
+	{
+		header.values_offset = offset;
+		offset = align_file_offset(offset + count * value_size);
+	}
+	if (with_index)
+	{
+		header.index_offset = offset;
+		header.index_slots = index.size();
+	}
+
+	std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+	if (!ofs)
+		throw_helper<std::runtime_error>("inplace_string_file: cannot open " + path);
+
+	const char padding[inplace_string_file_header::alignment] = {};
+	auto write = [&ofs](const void* p, std::size_t n) { ofs.write(static_cast<const char*>(p), static_cast<std::streamsize>(n)); };
+	auto pad = [&ofs, &write, &padding]()
+	{
+		const std::uint64_t pos = static_cast<std::uint64_t>(ofs.tellp());
+		write(padding, static_cast<std::size_t>(align_file_offset(pos) - pos));
+	};
+
+	char header_bytes[file_header_size] = {};
+	std::memcpy(header_bytes, &header, sizeof(header));
+	write(header_bytes, sizeof(header_bytes));
+
+	write(keys, count * sizeof(String));
+	pad();
+
+	if (value_size > 0)
+	{
+		write(values, count * value_size);
+		pad();
+	}
+
+	if (with_index)
+		write(index.data(), index.size() * sizeof(std::uint64_t));
+
+	ofs.close();
+	if (!ofs)
+		throw_helper<std::runtime_error>("inplace_string_file: cannot write " + path);
+}
+
+// Maps a file written by write_file and checks that it holds Strings and values of value_size bytes
+template <typename String>
+inline const inplace_string_file_header& open_file(const mapped_file& file, std::size_t value_size)
+{
+	auto fail = []() { throw_helper<std::runtime_error>("inplace_string_file: invalid or incompatible file"); };
+
+	if (file.size() < file_header_size)
+		fail();
+
+	const inplace_string_file_header& header = *reinterpret_cast<const inplace_string_file_header*>(file.data());
+	const std::uint64_t size = file.size();
+
+	if (std::memcmp(header.magic, inplace_string_file_header::magic_value, sizeof(header.magic)) != 0
+		|| header.version != inplace_string_file_header::current_version
+		|| header.char_size != sizeof(typename String::value_type)
+		|| header.capacity != file_capacity<String>()
+		|| header.layout_checksum != file_layout_checksum<String>(value_size)
+		|| header.value_size != value_size)
+		fail();
+
+	// sections within the file, checked against overflows
+	if (header.count > (size - file_header_size) / sizeof(String))
+		fail();
+	if (value_size > 0 && (header.values_offset % inplace_string_file_header::alignment != 0
+						   || header.values_offset > size || header.count > (size - header.values_offset) / value_size))
+		fail();
+	if (header.index_offset != 0 && (header.index_offset % inplace_string_file_header::alignment != 0
+									 || header.index_offset > size
+									 || header.index_slots > (size - header.index_offset) / sizeof(std::uint64_t)
+									 || (header.index_slots & (header.index_slots - 1)) != 0))
+		fail();
+
+	return header;
+}
+
+}
+
+// Writes [first, last) to path, with a hash index if with_index is set.
+template <std::size_t N, typename CharT, typename Traits>
+inline void write_inplace_string_file(const std::string& path,
+									  const basic_inplace_string<N, CharT, Traits>* first,
+									  const basic_inplace_string<N, CharT, Traits>* last,
+									  bool with_index = false)
+{
+	detail::write_file(path, first, static_cast<std::size_t>(last - first), nullptr, 0, with_index);
+}
+
+// Array of basic_inplace_string mapped from a file written by write_inplace_string_file: the strings are used in place,
+// without being copied, and the pages are shared between the processes mapping the same file.
+template <
+	std::size_t N,
+	typename CharT = char,
+	typename Traits = std::char_traits<CharT>>
+class mapped_inplace_string_file
+{
+public:
+	using value_type = basic_inplace_string<N, CharT, Traits>;
+	using size_type = std::size_t;
+	using const_pointer = const value_type*;
+	using const_iterator = const_pointer;
+
+	static_assert(detail::inplace_string_layout<value_type>::value, "mapped_inplace_string_file: unexpected string layout");
+
+	explicit mapped_inplace_string_file(const std::string& path);
+
+	const_pointer data() const noexcept    { return _data; }
+	size_type size() const noexcept        { return _size; }
+	bool empty() const noexcept            { return _size == 0; }
+
+	const_iterator begin() const noexcept { return _data; }
+	const_iterator end() const noexcept   { return _data + _size; }
+
+	const value_type& operator[](size_type i) const noexcept { assert(i < size()); return _data[i]; }
+
+	bool has_index() const noexcept { return _index != nullptr; }
+
+	// Position of key, size() if not found. Without index, the strings are scanned.
+	size_type find(const value_type& key) const noexcept;
+
+private:
+	detail::mapped_file _file;
+	const value_type* _data = nullptr;
+	size_type _size = 0;
+	const std::uint64_t* _index = nullptr;
+	size_type _index_slots = 0;
+};
+
+template <std::size_t N, typename CharT, typename Traits>
+mapped_inplace_string_file<N, CharT, Traits>::mapped_inplace_string_file(const std::string& path) :
+	_file(path)
+{
+	const inplace_string_file_header& header = detail::open_file<value_type>(_file, 0);
+
+	_data = reinterpret_cast<const value_type*>(_file.data() + detail::file_header_size);
+	_size = static_cast<size_type>(header.count);
+
+	if (header.index_offset != 0)
+	{
+		_index = reinterpret_cast<const std::uint64_t*>(_file.data() + header.index_offset);
+		_index_slots = static_cast<size_type>(header.index_slots);
+	}
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename mapped_inplace_string_file<N, CharT, Traits>::size_type
+mapped_inplace_string_file<N, CharT, Traits>::find(const value_type& key) const noexcept
+{
+	if (_index == nullptr)
+		return static_cast<size_type>(std::find(begin(), end(), key) - begin());
+
+	return detail::find_in_file_index(_index, _index_slots, _data, _size, key);
+}
+
+// Writes the map of keys [first, last) to values[0, last - first) to path, with its hash index. For duplicate keys, the
+// first one wins.
+template <std::size_t N, typename CharT, typename Traits, typename T>
+inline void write_inplace_string_map_file(const std::string& path,
+										  const basic_inplace_string<N, CharT, Traits>* first,
+										  const basic_inplace_string<N, CharT, Traits>* last,
+										  const T* values)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "write_inplace_string_map_file: values must be trivially copyable");
+
+	detail::write_file(path, first, static_cast<std::size_t>(last - first), values, sizeof(T), true);
+}
+
+// Read-only hash map from basic_inplace_string to trivially copyable values of type T, mapped from a file written by
+// write_inplace_string_map_file. Opening it does not read the file: the keys, values and hash index are used in place,
+// and the pages are loaded on first access and shared between the processes mapping the same file.
+template <
+	std::size_t N,
+	typename T,
+	typename CharT = char,
+	typename Traits = std::char_traits<CharT>>
+class mapped_inplace_string_map
+{
+public:
+	static_assert(std::is_trivially_copyable<T>::value, "mapped_inplace_string_map: values must be trivially copyable");
+	static_assert(alignof(T) <= inplace_string_file_header::alignment, "mapped_inplace_string_map: values are over-aligned");
+	static_assert(detail::inplace_string_layout<basic_inplace_string<N, CharT, Traits>>::value, "mapped_inplace_string_map: unexpected key layout");
+
+	using key_type = basic_inplace_string<N, CharT, Traits>;
+	using mapped_type = T;
+	using size_type = std::size_t;
+
+	explicit mapped_inplace_string_map(const std::string& path);
+
+	size_type size() const noexcept { return _size; }
+	bool empty() const noexcept     { return _size == 0; }
+
+	const key_type* keys() const noexcept { return _keys; }
+	const T* values() const noexcept      { return _values; }
+
+	// Value of key, nullptr if not found
+	const T* find(const key_type& key) const noexcept;
+	bool contains(const key_type& key) const noexcept    { return find(key) != nullptr; }
+	size_type count(const key_type& key) const noexcept  { return find(key) != nullptr; }
+
+	const T& at(const key_type& key) const;
+
+private:
+	detail::mapped_file _file;
+	const key_type* _keys = nullptr;
+	const T* _values = nullptr;
+	size_type _size = 0;
+	const std::uint64_t* _index = nullptr;
+	size_type _index_slots = 0;
+};
+
+template <std::size_t N, typename T, typename CharT, typename Traits>
+mapped_inplace_string_map<N, T, CharT, Traits>::mapped_inplace_string_map(const std::string& path) :
+	_file(path)
+{
+	const inplace_string_file_header& header = detail::open_file<key_type>(_file, sizeof(T));
+
+	if (header.index_offset == 0 || (header.count > 0 && header.values_offset == 0))
+		detail::throw_helper<std::runtime_error>("mapped_inplace_string_map: file without index or values");
+
+	_keys = reinterpret_cast<const key_type*>(_file.data() + detail::file_header_size);
+	_values = reinterpret_cast<const T*>(_file.data() + header.values_offset);
+	_size = static_cast<size_type>(header.count);
+	_index = reinterpret_cast<const std::uint64_t*>(_file.data() + header.index_offset);
+	_index_slots = static_cast<size_type>(header.index_slots);
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits>
+const T* mapped_inplace_string_map<N, T, CharT, Traits>::find(const key_type& key) const noexcept
+{
+	const size_type i = detail::find_in_file_index(_index, _index_slots, _keys, _size, key);
+	return i < _size ? _values + i : nullptr;
+}
+
+template <std::size_t N, typename T, typename CharT, typename Traits>
+const T& mapped_inplace_string_map<N, T, CharT, Traits>::at(const key_type& key) const
+{
+	const T* value = find(key);
+	if (value == nullptr)
+		detail::throw_helper<std::out_of_range>("mapped_inplace_string_map::at: key not found");
+
+	return *value;
+}
@@ -0,0 +1,855 @@
+#pragma once
+
+#include "inplace_string_vector.h"
+
+#include <cerrno>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define INPLACE_STRING_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// Replay of large files of records, e.g. captured market data, into batches of basic_inplace_string fields:
+//
+//   ingest_options options;
+//   options.threads = 4;
+//   ingest_file<15>("quotes.csv", options, [](const record_batch<15>& batch)
+//   {
+//       for (std::size_t i = 0; i < batch.size(); ++i)
+//           on_quote(batch.field(i, 0), batch.field(i, 1));
+//   });
+//
+// The file is read in blocks, which are parsed in parallel and handed to the consumer in file order, on the calling
+// thread. Up to in_flight blocks are read or parsed ahead of the consumer, their buffers and batches being reused. The
+// blocks are read with io_uring on Linux, by a thread keeping all the reads of the window in flight; elsewhere, or if
+// io_uring is not available, each parsing thread reads its block with pread.
+//
+// Records are either of a fixed size, split into fields at given offsets and widths, trailing spaces and NULs removed,
+// or delimited (e.g. lines), split into fields on a delimiter. Delimited records must be shorter than max_record_size:
+// each block is read together with the beginning of the next one, and parses the records starting in it. Fields longer
+// than N characters are cut, and counted by the batch.
+
+struct ingest_field
+{
+	std::size_t offset;
+	std::size_t width;
+};
+
+struct ingest_options
+{
+	std::size_t record_size = 0;       // fixed-size records if not 0, delimited otherwise
+	std::vector<ingest_field> fields;  // fields of the fixed-size records
+
+	char delimiter = '\n';             // end of the delimited records, followed or not by '\r' if '\n'
+	char field_delimiter = ',';
+	std::size_t max_record_size = 1 << 16;
+
+	std::size_t block_size = 1 << 22;
+	unsigned threads = 2;              // parsing threads
+	std::size_t in_flight = 8;         // blocks read or parsed ahead of the consumer
+	bool io_uring = true;
+};
+
+namespace detail
+{
+
+template <std::size_t N>
+class ingestion;
+
+}
+
+// Records parsed from a block of the file
+template <std::size_t N>
+class record_batch
+{
+public:
+	using value_type = inplace_string<N>;
+
+	// Position of the block in the file
+	std::size_t index() const noexcept { return _index; }
+
+	std::size_t size() const noexcept { return _offsets.size() - 1; }
+	bool empty() const noexcept       { return size() == 0; }
+
+	std::size_t field_count(std::size_t record) const noexcept { return _offsets[record + 1] - _offsets[record]; }
+
+	// Field j of record i, which must exist
+	const value_type& field(std::size_t i, std::size_t j) const noexcept
+	{
+		assert(j < field_count(i));
+		return _fields[_offsets[i] + j];
+	}
+
+	// Fields of all the records, one after the other
+	const inplace_string_vector<N>& fields() const noexcept { return _fields; }
+
+	// Number of fields cut to N characters
+	std::size_t truncated() const noexcept { return _truncated; }
+
+private:
+	friend class detail::ingestion<N>;
+
+	void clear(std::size_t index)
+	{
+		_index = index;
+		_fields.clear();
+		_offsets.assign(1, 0);
+		_truncated = 0;
+	}
+
+	void push_field(const char* p, std::size_t size)
+	{
+		if (size > N)
+		{
+			size = N;
+			++_truncated;
+		}
+		_fields.emplace_back(p, size);
+	}
+
+	void end_record() { _offsets.push_back(_fields.size()); }
+
+	inplace_string_vector<N> _fields;
+	std::vector<std::size_t> _offsets = std::vector<std::size_t>(1, 0);
+	std::size_t _index = 0;
+	std::size_t _truncated = 0;
+};
+
+namespace detail
+{
+
+// Read-only file read at given offsets, from any thread
+class input_file
+{
+public:
+	explicit input_file(const std::string& path);
+	~input_file();
+
+	input_file(const input_file&) = delete;
+	input_file& operator=(const input_file&) = delete;
+
+	std::uint64_t size() const noexcept { return _size; }
+
+	// Reads size bytes at offset, or up to the end of the file. Throws std::runtime_error on error.
+	std::size_t read(char* buffer, std::size_t size, std::uint64_t offset) const;
+
+#if defined(_WIN32)
+private:
+	HANDLE _file;
+#else
+	int fd() const noexcept { return _fd; }
+
+private:
+	int _fd;
+#endif
+	std::uint64_t _size;
+};
+
+#if defined(_WIN32)
+
+inline input_file::input_file(const std::string& path)
+{
+	_file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (_file == INVALID_HANDLE_VALUE)
+		throw_helper<std::runtime_error>("input_file: cannot open " + path);
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(_file, &size))
+	{
+		::CloseHandle(_file);
+		throw_helper<std::runtime_error>("input_file: cannot read " + path);
+	}
+	_size = static_cast<std::uint64_t>(size.QuadPart);
+}
+
+inline input_file::~input_file()
+{
+	::CloseHandle(_file);
+}
+
+inline std::size_t input_file::read(char* buffer, std::size_t size, std::uint64_t offset) const
+{
+	std::size_t done = 0;
+	while (done < size)
+	{
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(offset + done);
+		overlapped.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+
+		DWORD n = 0;
+		const DWORD count = static_cast<DWORD>(size - done < 0x40000000 ? size - done : 0x40000000);
+		if (!::ReadFile(_file, buffer + done, count, &n, &overlapped))
+		{
+			if (::GetLastError() == ERROR_HANDLE_EOF)
+				break;
+			throw_helper<std::runtime_error>("input_file: cannot read");
+		}
+		if (n == 0)
+			break;
+		done += n;
+	}
+	return done;
+}
+
+#else
+
+inline input_file::input_file(const std::string& path)
+{
+	_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (_fd < 0)
+		throw_helper<std::runtime_error>("input_file: cannot open " + path);
+
+	struct stat st;
+	if (::fstat(_fd, &st) != 0)
+	{
+		::close(_fd);
+		throw_helper<std::runtime_error>("input_file: cannot read " + path);
+	}
+	_size = static_cast<std::uint64_t>(st.st_size);
+}
+
+inline input_file::~input_file()
+{
+	::close(_fd);
+}
+
+inline std::size_t input_file::read(char* buffer, std::size_t size, std::uint64_t offset) const
+{
+	std::size_t done = 0;
+	while (done < size)
+	{
+		const ssize_t n = ::pread(_fd, buffer + done, size - done, static_cast<off_t>(offset + done));
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			throw_helper<std::runtime_error>("input_file: cannot read");
+		}
+		if (n == 0)
+			break;
+		done += static_cast<std::size_t>(n);
+	}
+	return done;
+}
+
+#endif
+
+#if defined(INPLACE_STRING_IO_URING)
+
+// Submission and completion queues of io_uring, used through the system calls: only reads are submitted
+class io_ring
+{
+public:
+	io_ring() = default;
+	~io_ring();
+
+	io_ring(const io_ring&) = delete;
+	io_ring& operator=(const io_ring&) = delete;
+
+	// False if io_uring is not available
+	bool open(unsigned entries) noexcept;
+
+	unsigned entries() const noexcept { return _sq_entries; }
+
+	// Queues a read, false if the submission queue is full
+	bool push_read(int fd, char* buffer, unsigned size, std::uint64_t offset, std::uint64_t user_data) noexcept;
+
+	// Submits the queued reads and waits for wait completions, returns -errno on error
+	int enter(unsigned submit, unsigned wait) noexcept;
+
+	// Next completion, false if none
+	bool pop(std::uint64_t& user_data, int& result) noexcept;
+
+private:
+	int _fd = -1;
+
+	void* _sq_map = nullptr;
+	std::size_t _sq_size = 0;
+	void* _cq_map = nullptr;
+	std::size_t _cq_size = 0;
+	io_uring_sqe* _sqes = nullptr;
+	std::size_t _sqes_size = 0;
+
+	unsigned* _sq_head = nullptr;
+	unsigned* _sq_tail = nullptr;
+	unsigned* _sq_array = nullptr;
+	unsigned _sq_mask = 0;
+	unsigned _sq_entries = 0;
+
+	unsigned* _cq_head = nullptr;
+	unsigned* _cq_tail = nullptr;
+	io_uring_cqe* _cqes = nullptr;
+	unsigned _cq_mask = 0;
+};
+
+inline bool io_ring::open(unsigned entries) noexcept
+{
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+
+	const long fd = ::syscall(__NR_io_uring_setup, entries, &params);
+	if (fd < 0)
+		return false;
+	_fd = static_cast<int>(fd);
+
+	_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		_sq_size = _cq_size = std::max(_sq_size, _cq_size);
+
+	_sq_map = ::mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+	if (_sq_map == MAP_FAILED)
+	{
+		_sq_map = nullptr;
+		return false;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		_cq_map = _sq_map;
+	}
+	else
+	{
+		_cq_map = ::mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+		if (_cq_map == MAP_FAILED)
+		{
+			_cq_map = nullptr;
+			return false;
+		}
+	}
+
+	_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes = ::mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+		return false;
+	_sqes = static_cast<io_uring_sqe*>(sqes);
+
+	char* sq = static_cast<char*>(_sq_map);
+	_sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	_sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	_sq_entries = params.sq_entries;
+
+	char* cq = static_cast<char*>(_cq_map);
+	_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+	_cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	return true;
+}
+
+inline io_ring::~io_ring()
+{
+	if (_sqes != nullptr)
+		::munmap(_sqes, _sqes_size);
+	if (_cq_map != nullptr && _cq_map != _sq_map)
+		::munmap(_cq_map, _cq_size);
+	if (_sq_map != nullptr)
+		::munmap(_sq_map, _sq_size);
+	if (_fd >= 0)
+		::close(_fd);
+}
+
+inline bool io_ring::push_read(int fd, char* buffer, unsigned size, std::uint64_t offset, std::uint64_t user_data) noexcept
+{
+	// the kernel moves the head, the tail is ours
+	const unsigned tail = *_sq_tail;
+	if (tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == _sq_entries)
+		return false;
+
+	const unsigned index = tail & _sq_mask;
+	io_uring_sqe* sqe = &_sqes[index];
+	std::memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+	sqe->len = size;
+	sqe->off = offset;
+	sqe->user_data = user_data;
+
+	_sq_array[index] = index;
+	__atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+inline int io_ring::enter(unsigned submit, unsigned wait) noexcept
+{
+	for (;;)
+	{
+		const long n = ::syscall(__NR_io_uring_enter, _fd, submit, wait, wait != 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+		if (n >= 0)
+			return 0;
+		if (errno != EINTR)
+			return -errno;
+	}
+}
+
+inline bool io_ring::pop(std::uint64_t& user_data, int& result) noexcept
+{
+	// the kernel moves the tail, the head is ours
+	const unsigned head = *_cq_head;
+	if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE))
+		return false;
+
+	const io_uring_cqe& cqe = _cqes[head & _cq_mask];
+	user_data = cqe.user_data;
+	result = cqe.res;
+
+	__atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+#endif
+
+template <std::size_t N>
+class ingestion
+{
+public:
+	ingestion(const std::string& path, const ingest_options& options);
+
+	template <typename Consumer>
+	std::size_t run(Consumer& consumer);
+
+private:
+	static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+	// Bytes of block k to read, and where its records start in the buffer
+	struct block_range
+	{
+		std::uint64_t offset;
+		std::size_t size;
+		std::size_t lead;
+	};
+
+	block_range range(std::size_t k) const noexcept;
+
+	// Parses blocks until all are parsed or the pipeline stops; work() records its exception
+	void work();
+	void work_blocks();
+	void parse(std::size_t k, const char* data, std::size_t size, record_batch<N>& batch) const;
+	void parse_record(const char* first, const char* last, record_batch<N>& batch) const;
+
+#if defined(INPLACE_STRING_IO_URING)
+	void read_ahead(io_ring& ring);
+	void read_blocks(io_ring& ring, unsigned& pending);
+#endif
+
+	// Hands the parsed blocks to the consumer in order, returns the number of records
+	template <typename Consumer>
+	std::size_t deliver(Consumer& consumer);
+
+#ifndef _NO_EXCEPTIONS
+	void fail() noexcept
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_error)
+			_error = std::current_exception();
+		_stop = true;
+		_changed.notify_all();
+	}
+#endif
+
+	const ingest_options& _options;
+	input_file _file;
+	std::size_t _block_size;
+	std::size_t _blocks;
+	std::size_t _window;
+	bool _uring = false;
+
+	std::mutex _mutex;
+	std::condition_variable _changed;
+	std::size_t _next = 0;      // next block to parse
+	std::size_t _delivered = 0; // blocks handed to the consumer
+	bool _stop = false;
+#ifndef _NO_EXCEPTIONS
+	std::exception_ptr _error;
+#endif
+
+	// Per slot of the window, for block k in slot k % window
+	std::vector<std::vector<char>> _buffers;
+	std::vector<std::size_t> _lengths;
+	std::vector<std::size_t> _read;   // block whose data is in the buffer
+	std::vector<std::size_t> _parsed; // block whose batch is ready
+	std::vector<record_batch<N>> _batches;
+};
+
+template <std::size_t N>
+ingestion<N>::ingestion(const std::string& path, const ingest_options& options) :
+	_options(options),
+	_file(path)
+{
+	if (options.record_size != 0)
+	{
+		for (const ingest_field& field : options.fields)
+			if (field.offset + field.width > options.record_size)
+				throw_helper<std::invalid_argument>("ingest_file: field past the end of the record");
+
+		// blocks of whole records
+		_block_size = std::max(options.record_size, options.block_size / options.record_size * options.record_size);
+	}
+	else
+	{
+		if (options.block_size == 0 || options.max_record_size == 0)
+			throw_helper<std::invalid_argument>("ingest_file: empty blocks or records");
+		_block_size = options.block_size;
+	}
+
+	_blocks = static_cast<std::size_t>((_file.size() + _block_size - 1) / _block_size);
+	_window = std::max<std::size_t>(1, options.in_flight);
+
+	const std::size_t buffer_size = _block_size + (options.record_size != 0 ? 0 : options.max_record_size + 1);
+	_buffers.resize(_window, std::vector<char>(buffer_size));
+	_lengths.resize(_window, 0);
+	_read.resize(_window, none);
+	_parsed.resize(_window, none);
+	_batches.resize(_window);
+}
+
+template <std::size_t N>
+typename ingestion<N>::block_range ingestion<N>::range(std::size_t k) const noexcept
+{
+	const std::uint64_t begin = static_cast<std::uint64_t>(k) * _block_size;
+	std::uint64_t end = begin + _block_size;
+
+	block_range r{begin, 0, 0};
+	if (_options.record_size == 0)
+	{
+		// from the last byte of the previous block, which tells whether a record starts the block, to the end of the
+		// records starting in the block
+		r.lead = k != 0 ? 1 : 0;
+		r.offset -= r.lead;
+		end += _options.max_record_size;
+	}
+
+	r.size = static_cast<std::size_t>(std::min(end, _file.size()) - r.offset);
+	return r;
+}
+
+template <std::size_t N>
+void ingestion<N>::parse_record(const char* first, const char* last, record_batch<N>& batch) const
+{
+	if (_options.record_size != 0)
+	{
+		for (const ingest_field& field : _options.fields)
+		{
+			const char* p = first + field.offset;
+			std::size_t width = field.width;
+			while (width != 0 && (p[width - 1] == ' ' || p[width - 1] == '\0'))
+				--width;
+			batch.push_field(p, width);
+		}
+	}
+	else
+	{
+		for (;;)
+		{
+			const void* q = std::memchr(first, _options.field_delimiter, static_cast<std::size_t>(last - first));
+			const char* field_end = q != nullptr ? static_cast<const char*>(q) : last;
+			batch.push_field(first, static_cast<std::size_t>(field_end - first));
+			if (field_end == last)
+				break;
+			first = field_end + 1;
+		}
+	}
+	batch.end_record();
+}
+
+template <std::size_t N>
+void ingestion<N>::parse(std::size_t k, const char* data, std::size_t size, record_batch<N>& batch) const
+{
+	batch.clear(k);
+
+	if (_options.record_size != 0)
+	{
+		// an incomplete last record is ignored
+		for (std::size_t i = 0; i + _options.record_size <= size; i += _options.record_size)
+			parse_record(data + i, data + i + _options.record_size, batch);
+		return;
+	}
+
+	const block_range r = range(k);
+	const char delimiter = _options.delimiter;
+	const bool at_end = r.offset + size == _file.size();
+
+	// the first record starts after the first delimiter, unless the block starts the file
+	std::size_t start = 0;
+	if (r.lead != 0)
+	{
+		const void* q = std::memchr(data, delimiter, size);
+		if (q == nullptr)
+		{
+			if (!at_end)
+				throw_helper<std::runtime_error>("ingest_file: record longer than max_record_size");
+			return;
+		}
+		start = static_cast<std::size_t>(static_cast<const char*>(q) - data) + 1;
+	}
+
+	while (start < size && start - r.lead < _block_size)
+	{
+		const void* q = std::memchr(data + start, delimiter, size - start);
+		if (q == nullptr && !at_end)
+			throw_helper<std::runtime_error>("ingest_file: record longer than max_record_size");
+
+		const char* last = q != nullptr ? static_cast<const char*>(q) : data + size;
+		const char* first = data + start;
+		start = static_cast<std::size_t>(last - data) + 1;
+
+		if (delimiter == '\n' && last != first && last[-1] == '\r')
+			--last;
+		if (last != first)
+			parse_record(first, last, batch);
+	}
+}
+
+template <std::size_t N>
+void ingestion<N>::work()
+{
+#ifndef _NO_EXCEPTIONS
+	try
+	{
+		work_blocks();
+	}
+	catch (...)
+	{
+		fail();
+	}
+#else
+	work_blocks();
+#endif
+}
+
+template <std::size_t N>
+void ingestion<N>::work_blocks()
+{
+	for (;;)
+	{
+		std::size_t k;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_changed.wait(lock, [this]() { return _stop || _next == _blocks || _next < _delivered + _window; });
+			if (_stop || _next == _blocks)
+				return;
+			k = _next++;
+		}
+
+		const std::size_t slot = k % _window;
+		if (_uring)
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_changed.wait(lock, [this, k, slot]() { return _stop || _read[slot] == k; });
+			if (_stop)
+				return;
+		}
+		else
+		{
+			const block_range r = range(k);
+			_lengths[slot] = _file.read(_buffers[slot].data(), r.size, r.offset);
+		}
+
+		parse(k, _buffers[slot].data(), _lengths[slot], _batches[slot]);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_parsed[slot] = k;
+		_changed.notify_all();
+	}
+}
+
+#if defined(INPLACE_STRING_IO_URING)
+
+template <std::size_t N>
+void ingestion<N>::read_ahead(io_ring& ring)
+{
+	unsigned pending = 0; // submitted, not completed
+
+#ifndef _NO_EXCEPTIONS
+	try
+	{
+		read_blocks(ring, pending);
+	}
+	catch (...)
+	{
+		fail();
+
+		// waits for the reads in flight
+		std::uint64_t k;
+		int result;
+		while (pending != 0 && ring.enter(0, 1) == 0)
+			while (ring.pop(k, result))
+				--pending;
+	}
+#else
+	read_blocks(ring, pending);
+#endif
+}
+
+template <std::size_t N>
+void ingestion<N>::read_blocks(io_ring& ring, unsigned& pending)
+{
+	std::size_t submitted = 0;
+	std::size_t completed = 0;
+
+	while (completed < _blocks)
+	{
+		unsigned queued = 0;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			if (pending == 0)
+				_changed.wait(lock, [&]() { return _stop || submitted < _delivered + _window; });
+
+			// the reads in flight must complete before their buffers are released
+			if (_stop && pending == 0)
+				return;
+
+			while (!_stop && submitted < _blocks && submitted < _delivered + _window)
+			{
+				const std::size_t slot = submitted % _window;
+				const block_range r = range(submitted);
+				if (!ring.push_read(_file.fd(), _buffers[slot].data(), static_cast<unsigned>(r.size), r.offset, submitted))
+					break;
+				++submitted;
+				++queued;
+				++pending;
+			}
+		}
+
+		const int error = ring.enter(queued, pending != 0 ? 1 : 0);
+		if (error < 0)
+			throw_helper<std::runtime_error>("ingest_file: io_uring_enter failed");
+
+		std::uint64_t k;
+		int result;
+		while (ring.pop(k, result))
+		{
+			--pending;
+			++completed;
+
+			// short or failed read: completed with pread
+			const std::size_t slot = static_cast<std::size_t>(k) % _window;
+			const block_range r = range(static_cast<std::size_t>(k));
+			std::size_t length = result > 0 ? static_cast<std::size_t>(result) : 0;
+			if (length < r.size)
+				length += _file.read(_buffers[slot].data() + length, r.size - length, r.offset + length);
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			_lengths[slot] = length;
+			_read[slot] = static_cast<std::size_t>(k);
+			_changed.notify_all();
+		}
+	}
+}
+
+#endif
+
+template <std::size_t N>
+template <typename Consumer>
+std::size_t ingestion<N>::run(Consumer& consumer)
+{
+	if (_blocks == 0)
+		return 0;
+
+	std::vector<std::thread> threads;
+
+#if defined(INPLACE_STRING_IO_URING)
+	io_ring ring;
+	_uring = _options.io_uring && ring.open(static_cast<unsigned>(std::min<std::size_t>(_window, 256)));
+	if (_uring)
+		threads.emplace_back([this, &ring]() { read_ahead(ring); });
+#endif
+
+	const unsigned workers = std::max(1u, _options.threads);
+	for (unsigned i = 0; i < workers; ++i)
+		threads.emplace_back([this]() { work(); });
+
+	std::size_t records = 0;
+#ifndef _NO_EXCEPTIONS
+	std::exception_ptr error;
+	try
+	{
+		records = deliver(consumer);
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+#else
+	records = deliver(consumer);
+#endif
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+#ifndef _NO_EXCEPTIONS
+		if (!error)
+			error = _error;
+#endif
+		_changed.notify_all();
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+#ifndef _NO_EXCEPTIONS
+	if (error)
+		std::rethrow_exception(error);
+#endif
+	return records;
+}
+
+template <std::size_t N>
+template <typename Consumer>
+std::size_t ingestion<N>::deliver(Consumer& consumer)
+{
+	std::size_t records = 0;
+	for (std::size_t k = 0; k < _blocks; ++k)
+	{
+		const std::size_t slot = k % _window;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_changed.wait(lock, [this, k, slot]() { return _stop || _parsed[slot] == k; });
+			if (_stop)
+				break;
+		}
+
+		consumer(static_cast<const record_batch<N>&>(_batches[slot]));
+		records += _batches[slot].size();
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		++_delivered;
+		_changed.notify_all();
+	}
+	return records;
+}
+
+}
+
+// Parses the records of the file on options.threads threads, and calls consumer(const record_batch<N>&) on the calling
+// thread for each block, in file order. Returns the number of records. Rethrows the exceptions of the consumer, and
+// throws std::runtime_error if the file cannot be read or holds a delimited record longer than max_record_size.
+template <std::size_t N, typename Consumer>
+std::size_t ingest_file(const std::string& path, const ingest_options& options, Consumer&& consumer)
+{
+	detail::ingestion<N> pipeline(path, options);
+	return pipeline.run(consumer);
+}
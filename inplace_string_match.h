@@ -0,0 +1,292 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <stdexcept>
+
+// Dispatch of a string over a set of string literals known at compile time, without computing the length of the
+// literals at run time:
+//
+//   switch (match(msg_type, "NewOrderSingle", "OrderCancelRequest", "OrderCancelReplaceRequest"))
+//
+// match() compares the size of the string with the size of each literal, and only compares the characters of the
+// literals of the same size. For larger sets, make_string_matcher() builds at compile time a perfect hash of the
+// literals and its table: a lookup is then a hash of the first and last 8 characters, two table loads and one
+// comparison.
+//
+//   static constexpr auto fields = make_string_matcher("Symbol", "Side", "OrderQty", "Price");
+//   switch (fields(name))
+//   {
+//   case fields.index_of("Symbol"): ...
+//   }
+
+namespace detail
+{
+
+// Characters [p, p + n) as a little-endian word, n <= 8
+constexpr std::uint64_t match_word(const char* p, std::size_t n) noexcept
+{
+	std::uint64_t w = 0;
+	for (std::size_t i = 0; i < n; ++i)
+		w |= std::uint64_t{static_cast<unsigned char>(p[i])} << (8 * i);
+	return w;
+}
+
+inline std::uint64_t load_match_word(const char* p) noexcept
+{
+	std::uint64_t w;
+	std::memcpy(&w, p, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	w = __builtin_bswap64(w);
+#endif
+	return w;
+}
+
+// The first and the last 8 characters, and the size: distinct for strings of up to 16 characters
+struct match_key
+{
+	std::uint64_t head;
+	std::uint64_t tail;
+	std::size_t size;
+};
+
+constexpr match_key make_match_key(const char* p, std::size_t n) noexcept
+{
+	const std::size_t k = n < 8 ? n : 8;
+	return {match_word(p, k), match_word(p + (n - k), k), n};
+}
+
+// Same as make_match_key, with whole-word loads for strings of at least 8 characters
+inline match_key load_match_key(const char* p, std::size_t n) noexcept
+{
+	if (n < 8)
+	{
+		const std::uint64_t w = match_word(p, n);
+		return {w, w, n};
+	}
+	return {load_match_word(p), load_match_word(p + n - 8), n};
+}
+
+constexpr std::uint64_t match_hash(const match_key& key, std::uint64_t seed) noexcept
+{
+	std::uint64_t h = (key.head ^ seed) * 0x9e3779b97f4a7c15ULL;
+	h = (h ^ (h >> 32) ^ key.tail) * 0xc2b2ae3d27d4eb4fULL;
+	h = (h ^ (h >> 32) ^ key.size) * 0x9e3779b97f4a7c15ULL;
+	return h ^ (h >> 32);
+}
+
+// Slot of a key of hash h in a table of mask + 1 slots, for the seed of its bucket
+constexpr std::size_t match_slot(std::uint64_t h, std::uint32_t seed, std::size_t mask) noexcept
+{
+	const std::uint64_t x = (h ^ (seed * 0x9e3779b97f4a7c15ULL)) * 0xc2b2ae3d27d4eb4fULL;
+	return static_cast<std::size_t>(x >> 32) & mask;
+}
+
+constexpr std::size_t match_power_of_two(std::size_t n) noexcept
+{
+	std::size_t size = 1;
+	while (size < n)
+		size *= 2;
+	return size;
+}
+
+template <std::size_t... M>
+constexpr std::size_t max_literal_size() noexcept
+{
+	const std::size_t sizes[] = {(M - 1)...};
+
+	std::size_t max = 0;
+	for (std::size_t size : sizes)
+		max = size > max ? size : max;
+	return max;
+}
+
+constexpr bool match_equal(const char* a, const char* b, std::size_t n) noexcept
+{
+	for (std::size_t i = 0; i < n; ++i)
+		if (a[i] != b[i])
+			return false;
+	return true;
+}
+
+}
+
+// Position of s in keys, sizeof...(keys) if not found
+template <std::size_t N, typename Traits, std::size_t... M>
+inline std::size_t match(const basic_inplace_string<N, char, Traits>& s, const char (&... keys)[M]) noexcept
+{
+	std::size_t index = 0;
+	static_cast<void>(((s.size() == M - 1 && Traits::compare(s.data(), keys, M - 1) == 0 ? true : (++index, false)) || ...));
+	return index;
+}
+
+template <typename Traits, std::size_t... M>
+inline std::size_t match(basic_string_view<char, Traits> s, const char (&... keys)[M]) noexcept
+{
+	std::size_t index = 0;
+	static_cast<void>(((s.size() == M - 1 && Traits::compare(s.data(), keys, M - 1) == 0 ? true : (++index, false)) || ...));
+	return index;
+}
+
+// Perfect hash of K string literals of up to MaxSize characters, see make_string_matcher, built by hash and displace
+// (Belazzougui, Botelho and Dietzfelbinger, "Hash, displace, and compress"): the hash of a key selects one of about K / 4
+// buckets, and the seed of the bucket its slot among twice as many slots as keys. The seeds are searched at compile
+// time, largest buckets first, each until the keys of its bucket fall in free slots; with a table at most half full,
+// a few seeds are tried per bucket whatever the number of keys.
+template <std::size_t K, std::size_t MaxSize>
+class string_matcher
+{
+public:
+	static_assert(K > 0 && K < 65535, "string_matcher: between 1 and 65534 keys");
+
+	static constexpr std::size_t npos = K;
+
+	static constexpr std::size_t table_size = detail::match_power_of_two(2 * K);
+	static constexpr std::size_t bucket_count = detail::match_power_of_two((K + 3) / 4);
+
+	template <std::size_t... M>
+	constexpr explicit string_matcher(const char (&... keys)[M]);
+
+	constexpr std::size_t size() const noexcept { return K; }
+
+	// Position of the literal key, npos if not one of the keys. Meant for case labels.
+	template <std::size_t M>
+	constexpr std::size_t index_of(const char (&key)[M]) const noexcept;
+
+	// Position of s, npos if not found
+	template <std::size_t N, typename Traits>
+	std::size_t operator()(const basic_inplace_string<N, char, Traits>& s) const noexcept { return find(s.data(), s.size()); }
+
+	template <typename Traits>
+	std::size_t operator()(basic_string_view<char, Traits> s) const noexcept { return find(s.data(), s.size()); }
+
+private:
+	std::size_t find(const char* p, std::size_t n) const noexcept
+	{
+		if (n > MaxSize)
+			return npos;
+
+		const std::uint64_t h = detail::match_hash(detail::load_match_key(p, n), 0);
+		const std::size_t i = _table[detail::match_slot(h, _seeds[h & (bucket_count - 1)], table_size - 1)];
+		return i != npos && _sizes[i] == n && std::memcmp(_keys[i], p, n) == 0 ? i : npos;
+	}
+
+	char _keys[K][MaxSize + 1];
+	std::size_t _sizes[K];
+	std::uint16_t _table[table_size];
+	std::uint32_t _seeds[bucket_count];
+};
+
+template <std::size_t K, std::size_t MaxSize>
+template <std::size_t... M>
+constexpr string_matcher<K, MaxSize>::string_matcher(const char (&... keys)[M]) :
+	_keys{},
+	_sizes{},
+	_table{},
+	_seeds{}
+{
+	static_assert(sizeof...(M) == K, "string_matcher: wrong number of keys");
+
+	const char* ptrs[K] = {keys...};
+	const std::size_t sizes[K] = {(M - 1)...};
+
+	// keys sorted by bucket
+	std::uint64_t hashes[K] = {};
+	std::size_t bucket_sizes[bucket_count] = {};
+	for (std::size_t i = 0; i < K; ++i)
+	{
+		for (std::size_t j = 0; j < sizes[i]; ++j)
+			_keys[i][j] = ptrs[i][j];
+		_sizes[i] = sizes[i];
+
+		hashes[i] = detail::match_hash(detail::make_match_key(_keys[i], _sizes[i]), 0);
+		++bucket_sizes[static_cast<std::size_t>(hashes[i]) & (bucket_count - 1)];
+	}
+
+	std::size_t offsets[bucket_count + 1] = {};
+	std::size_t max_bucket_size = 0;
+	for (std::size_t b = 0; b < bucket_count; ++b)
+	{
+		offsets[b + 1] = offsets[b] + bucket_sizes[b];
+		max_bucket_size = bucket_sizes[b] > max_bucket_size ? bucket_sizes[b] : max_bucket_size;
+	}
+
+	std::size_t sorted[K] = {};
+	std::size_t filled[bucket_count] = {};
+	for (std::size_t i = 0; i < K; ++i)
+	{
+		const std::size_t b = static_cast<std::size_t>(hashes[i]) & (bucket_count - 1);
+		sorted[offsets[b] + filled[b]++] = i;
+	}
+
+	// keys of equal hashes cannot be told apart by any seed
+	for (std::size_t b = 0; b < bucket_count; ++b)
+	{
+		for (std::size_t x = offsets[b]; x < offsets[b + 1]; ++x)
+		{
+			for (std::size_t y = offsets[b]; y < x; ++y)
+			{
+				const std::size_t i = sorted[x];
+				const std::size_t j = sorted[y];
+				if (hashes[i] != hashes[j])
+					continue;
+				if (_sizes[i] == _sizes[j] && detail::match_equal(_keys[i], _keys[j], _sizes[i]))
+					detail::throw_helper<std::invalid_argument>("string_matcher: duplicate keys");
+				// keys of more than 16 characters of the same size, sharing their first and last 8 characters
+				detail::throw_helper<std::invalid_argument>("string_matcher: keys with the same hash");
+			}
+		}
+	}
+
+	for (std::size_t s = 0; s < table_size; ++s)
+		_table[s] = static_cast<std::uint16_t>(npos);
+
+	// largest buckets first, while most slots are free
+	for (std::size_t size = max_bucket_size; size != 0; --size)
+	{
+		for (std::size_t b = 0; b < bucket_count; ++b)
+		{
+			if (bucket_sizes[b] != size)
+				continue;
+
+			for (std::uint32_t seed = 0;; ++seed)
+			{
+				// places the keys of the bucket, undone at the first one falling in a taken slot
+				std::size_t placed = 0;
+				for (; placed < size; ++placed)
+				{
+					const std::size_t i = sorted[offsets[b] + placed];
+					const std::size_t slot = detail::match_slot(hashes[i], seed, table_size - 1);
+					if (_table[slot] != npos)
+						break;
+					_table[slot] = static_cast<std::uint16_t>(i);
+				}
+
+				if (placed == size)
+				{
+					_seeds[b] = seed;
+					break;
+				}
+
+				while (placed-- != 0)
+					_table[detail::match_slot(hashes[sorted[offsets[b] + placed]], seed, table_size - 1)] = static_cast<std::uint16_t>(npos);
+			}
+		}
+	}
+}
+
+template <std::size_t K, std::size_t MaxSize>
+template <std::size_t M>
+constexpr std::size_t string_matcher<K, MaxSize>::index_of(const char (&key)[M]) const noexcept
+{
+	for (std::size_t i = 0; i < K; ++i)
+		if (_sizes[i] == M - 1 && detail::match_equal(_keys[i], key, M - 1))
+			return i;
+	return npos;
+}
+
+template <std::size_t... M>
+constexpr string_matcher<sizeof...(M), detail::max_literal_size<M...>()> make_string_matcher(const char (&... keys)[M])
+{
+	return string_matcher<sizeof...(M), detail::max_literal_size<M...>()>(keys...);
+}
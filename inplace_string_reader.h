@@ -0,0 +1,163 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <cerrno>
+#include <memory>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Reads the lines of a file descriptor into inplace_string<N>, e.g. to parse multi-gigabyte logs: the input is read
+// in large blocks into a buffer allocated once, which is scanned for '\n' with memchr, and each line is copied once,
+// from the buffer into the string. The '\n' is not stored, a last line without '\n' is returned as well.
+//
+//   line_reader<255> reader(fd);
+//   inplace_string<255> line;
+//   while (reader.next(line))
+//       ...
+//
+// A line longer than N characters is cut to its first N characters, the rest of the line being skipped, and counted by
+// truncated(). The file descriptor is not closed by the reader.
+template <std::size_t N>
+class line_reader
+{
+public:
+	using value_type = inplace_string<N>;
+
+	static constexpr std::size_t default_buffer_size = 1 << 20;
+
+	explicit line_reader(int fd, std::size_t buffer_size = default_buffer_size);
+
+	line_reader(const line_reader&) = delete;
+	line_reader& operator=(const line_reader&) = delete;
+
+	// Next line, false at the end of the input. Throws std::runtime_error if the descriptor cannot be read.
+	bool next(value_type& line);
+
+	// Number of lines read so far, and number of those cut to N characters
+	std::size_t lines() const noexcept     { return _lines; }
+	std::size_t truncated() const noexcept { return _truncated; }
+
+private:
+	// Appends to the buffer, after moving its pending part to the front. Returns false at the end of the input.
+	bool fill();
+
+	void emit(value_type& line, const char* first, std::size_t size) noexcept
+	{
+		if (size > N)
+		{
+			size = N;
+			++_truncated;
+		}
+		line = value_type(first, size);
+		++_lines;
+	}
+
+	int _fd;
+	std::unique_ptr<char[]> _buffer;
+	std::size_t _capacity;
+	std::size_t _begin = 0; // first character of the pending line
+	std::size_t _end = 0;   // end of the characters read
+	bool _eof = false;
+
+	std::size_t _lines = 0;
+	std::size_t _truncated = 0;
+};
+
+template <std::size_t N>
+line_reader<N>::line_reader(int fd, std::size_t buffer_size) :
+	_fd(fd),
+	_capacity(buffer_size)
+{
+	if (buffer_size <= N)
+		detail::throw_helper<std::invalid_argument>("line_reader: buffer smaller than a line");
+
+	_buffer.reset(new char[buffer_size]);
+}
+
+template <std::size_t N>
+bool line_reader<N>::fill()
+{
+	if (_begin != 0)
+	{
+		std::memmove(_buffer.get(), _buffer.get() + _begin, _end - _begin);
+		_end -= _begin;
+		_begin = 0;
+	}
+
+	while (_end < _capacity)
+	{
+#if defined(_WIN32)
+		const int n = ::_read(_fd, _buffer.get() + _end, static_cast<unsigned int>(_capacity - _end < 0x40000000 ? _capacity - _end : 0x40000000));
+#else
+		const ssize_t n = ::read(_fd, _buffer.get() + _end, _capacity - _end);
+#endif
+		if (n > 0)
+		{
+			_end += static_cast<std::size_t>(n);
+			return true;
+		}
+		if (n == 0)
+			break;
+		if (errno != EINTR)
+			detail::throw_helper<std::runtime_error>("line_reader: cannot read");
+	}
+
+	_eof = true;
+	return false;
+}
+
+template <std::size_t N>
+bool line_reader<N>::next(value_type& line)
+{
+	std::size_t scanned = _begin;
+
+	for (;;)
+	{
+		const char* first = _buffer.get() + _begin;
+		const void* nl = std::memchr(_buffer.get() + scanned, '\n', _end - scanned);
+		if (nl != nullptr)
+		{
+			const char* last = static_cast<const char*>(nl);
+			emit(line, first, static_cast<std::size_t>(last - first));
+			_begin = static_cast<std::size_t>(last - _buffer.get()) + 1;
+			return true;
+		}
+
+		if (_eof || (_begin == 0 && _end == _capacity))
+			break;
+
+		scanned = _end - _begin;
+		fill();
+	}
+
+	if (!_eof)
+	{
+		// line longer than the buffer: keep its first N characters, skip the rest
+		emit(line, _buffer.get(), _capacity);
+		_begin = _end = 0;
+		while (fill())
+		{
+			const void* nl = std::memchr(_buffer.get(), '\n', _end);
+			if (nl != nullptr)
+			{
+				_begin = static_cast<std::size_t>(static_cast<const char*>(nl) - _buffer.get()) + 1;
+				break;
+			}
+			_end = 0;
+		}
+		return true;
+	}
+
+	// last line, without '\n'
+	if (_begin == _end)
+		return false;
+
+	emit(line, _buffer.get() + _begin, _end - _begin);
+	_begin = _end;
+	return true;
+}
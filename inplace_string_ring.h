@@ -0,0 +1,509 @@
+#pragma once
+
+#include "atomic_inplace_string.h"
+
+#include <new>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Bounded ring buffers of trivially copyable records, e.g. messages made of basic_inplace_string fields, passed from a
+// feed handler to strategy threads or processes. The ring lives in a caller-provided block of memory, which may be a
+// shared_memory segment mapped by several processes:
+//
+//   shared_memory shm = shared_memory::create("/quotes", spsc_ring<quote>::memory_size(4096));
+//   spsc_ring<quote> ring = spsc_ring<quote>::create(shm.data(), 4096);       // in the feed handler
+//   shared_memory shm = shared_memory::open("/quotes");                       // in the strategy
+//   spsc_ring<quote> ring = spsc_ring<quote>::attach(shm.data(), shm.size());
+//
+// Each record occupies its own cache lines. Producers claim a batch of records, fill it in place and publish it;
+// the consumer peeks at a batch of published records and consumes it. spsc_ring allows one producer thread,
+// mpsc_ring any number of them; both allow one consumer thread.
+
+namespace detail
+{
+
+constexpr std::size_t ring_alignment = 64;
+
+struct ring_header
+{
+	static constexpr char magic_value[8] = {'I', 'P', 'S', 'R', 'I', 'N', 'G', '\0'};
+	static constexpr std::uint32_t version_value = 1;
+
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t multiple_producers;
+	std::uint64_t record_size;
+	std::uint64_t slot_size;
+	std::uint64_t capacity;
+
+	alignas(ring_alignment) std::atomic<std::uint64_t> head; // next position to claim
+	alignas(ring_alignment) std::atomic<std::uint64_t> tail; // next position to consume
+};
+
+// Atomics shared between processes must not rely on a lock private to each process
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "basic_ring: 64-bit atomics must be lock-free");
+
+template <typename T, bool MultipleProducers>
+struct alignas(ring_alignment) ring_slot
+{
+	T value;
+};
+
+// Each slot of mpsc_ring holds the position of its record plus one once published
+template <typename T>
+struct alignas(ring_alignment) ring_slot<T, true>
+{
+	std::atomic<std::uint64_t> sequence;
+	T value;
+};
+
+}
+
+// Consecutive records of a ring, wrapping around its end
+template <typename Slot>
+class ring_batch
+{
+public:
+	using value_type = decltype(Slot::value);
+
+	ring_batch() = default;
+	ring_batch(Slot* slots, std::uint64_t mask, std::uint64_t position, std::size_t size) noexcept :
+		_slots(slots), _mask(mask), _position(position), _size(size) {}
+
+	std::size_t size() const noexcept       { return _size; }
+	bool empty() const noexcept             { return _size == 0; }
+	std::uint64_t position() const noexcept { return _position; }
+
+	value_type& operator[](std::size_t i) const noexcept
+	{
+		assert(i < _size);
+		return _slots[(_position + i) & _mask].value;
+	}
+
+private:
+	Slot* _slots = nullptr;
+	std::uint64_t _mask = 0;
+	std::uint64_t _position = 0;
+	std::size_t _size = 0;
+};
+
+template <typename T, bool MultipleProducers>
+class basic_ring
+{
+	using slot = detail::ring_slot<T, MultipleProducers>;
+
+public:
+	static_assert(std::is_trivially_copyable<T>::value, "basic_ring: records must be trivially copyable");
+
+	using value_type = T;
+	using batch = ring_batch<slot>;
+
+	// Bytes of memory for a ring of capacity records
+	static constexpr std::size_t memory_size(std::size_t capacity) noexcept { return sizeof(detail::ring_header) + capacity * sizeof(slot); }
+
+	// Initializes an empty ring in memory, aligned on 64 bytes. capacity is a power of two.
+	static basic_ring create(void* memory, std::size_t capacity);
+
+	// Ring previously created in size bytes of memory, possibly by another process. Throws std::runtime_error if the
+	// memory does not hold a ring of T, or is smaller than the ring.
+	static basic_ring attach(void* memory, std::size_t size);
+
+	basic_ring() = default;
+
+	std::size_t capacity() const noexcept { return static_cast<std::size_t>(_header->capacity); }
+
+	// Number of claimed records not consumed yet, approximate while the ring is used
+	std::size_t size() const noexcept
+	{
+		return static_cast<std::size_t>(_header->head.load(std::memory_order_relaxed) - _header->tail.load(std::memory_order_relaxed));
+	}
+
+	// Producer: up to n free records, to be filled then published. A producer of spsc_ring must publish a batch before
+	// claiming the next one.
+	batch claim(std::size_t n) noexcept;
+	void publish(const batch& b) noexcept;
+	bool try_push(const T& record) noexcept;
+
+	// Consumer: up to n published records, to be read then consumed in order
+	batch peek(std::size_t n) noexcept;
+	void consume(std::size_t n) noexcept;
+	bool try_pop(T& record) noexcept;
+
+private:
+	basic_ring(detail::ring_header* header) noexcept :
+		_header(header),
+		_slots(reinterpret_cast<slot*>(header + 1)),
+		_mask(header->capacity - 1),
+		_cached_tail(header->tail.load(std::memory_order_acquire)),
+		_cached_head(header->head.load(std::memory_order_acquire))
+	{
+	}
+
+	detail::ring_header* _header = nullptr;
+	slot* _slots = nullptr;
+	std::uint64_t _mask = 0;
+
+	// Last positions seen of the other side, to avoid sharing its cache line on every call (single producer)
+	std::uint64_t _cached_tail = 0;
+	std::uint64_t _cached_head = 0;
+};
+
+template <typename T> using spsc_ring = basic_ring<T, false>;
+template <typename T> using mpsc_ring = basic_ring<T, true>;
+
+template <typename T, bool MultipleProducers>
+basic_ring<T, MultipleProducers> basic_ring<T, MultipleProducers>::create(void* memory, std::size_t capacity)
+{
+	if (reinterpret_cast<std::uintptr_t>(memory) % detail::ring_alignment != 0)
+		detail::throw_helper<std::invalid_argument>("basic_ring: memory must be aligned on 64 bytes");
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+		detail::throw_helper<std::invalid_argument>("basic_ring: capacity must be a power of two");
+
+	detail::ring_header* header = new (memory) detail::ring_header();
+	std::memcpy(header->magic, detail::ring_header::magic_value, sizeof(header->magic));
+	header->version = detail::ring_header::version_value;
+	header->multiple_producers = MultipleProducers;
+	header->record_size = sizeof(T);
+	header->slot_size = sizeof(slot);
+	header->capacity = capacity;
+
+	slot* slots = reinterpret_cast<slot*>(header + 1);
+	for (std::size_t i = 0; i < capacity; ++i)
+		new (&slots[i]) slot();
+
+	std::atomic_thread_fence(std::memory_order_release);
+	return basic_ring(header);
+}
+
+template <typename T, bool MultipleProducers>
+basic_ring<T, MultipleProducers> basic_ring<T, MultipleProducers>::attach(void* memory, std::size_t size)
+{
+	if (reinterpret_cast<std::uintptr_t>(memory) % detail::ring_alignment != 0)
+		detail::throw_helper<std::invalid_argument>("basic_ring: memory must be aligned on 64 bytes");
+	if (size < sizeof(detail::ring_header))
+		detail::throw_helper<std::runtime_error>("basic_ring: not a ring");
+
+	detail::ring_header* header = static_cast<detail::ring_header*>(memory);
+
+	if (std::memcmp(header->magic, detail::ring_header::magic_value, sizeof(header->magic)) != 0)
+		detail::throw_helper<std::runtime_error>("basic_ring: not a ring");
+	if (header->version != detail::ring_header::version_value || header->multiple_producers != MultipleProducers ||
+		header->record_size != sizeof(T) || header->slot_size != sizeof(slot))
+		detail::throw_helper<std::runtime_error>("basic_ring: incompatible ring");
+
+	// a corrupted capacity would index slots out of the memory
+	const std::uint64_t capacity = header->capacity;
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0 || capacity > (size - sizeof(detail::ring_header)) / sizeof(slot))
+		detail::throw_helper<std::runtime_error>("basic_ring: invalid capacity");
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return basic_ring(header);
+}
+
+template <typename T, bool MultipleProducers>
+typename basic_ring<T, MultipleProducers>::batch basic_ring<T, MultipleProducers>::claim(std::size_t n) noexcept
+{
+	const std::uint64_t capacity = _header->capacity;
+	std::uint64_t head = _header->head.load(std::memory_order_relaxed);
+
+	if constexpr (MultipleProducers)
+	{
+		for (;;)
+		{
+			const std::uint64_t free = capacity - (head - _header->tail.load(std::memory_order_acquire));
+			const std::size_t count = static_cast<std::size_t>(n < free ? n : free);
+			if (count == 0)
+				return batch();
+
+			if (_header->head.compare_exchange_weak(head, head + count, std::memory_order_relaxed, std::memory_order_relaxed))
+				return batch(_slots, _mask, head, count);
+		}
+	}
+	else
+	{
+		std::uint64_t free = capacity - (head - _cached_tail);
+		if (free < n)
+		{
+			_cached_tail = _header->tail.load(std::memory_order_acquire);
+			free = capacity - (head - _cached_tail);
+		}
+		return batch(_slots, _mask, head, static_cast<std::size_t>(n < free ? n : free));
+	}
+}
+
+template <typename T, bool MultipleProducers>
+void basic_ring<T, MultipleProducers>::publish(const batch& b) noexcept
+{
+	if constexpr (MultipleProducers)
+	{
+		for (std::size_t i = 0; i < b.size(); ++i)
+			_slots[(b.position() + i) & _mask].sequence.store(b.position() + i + 1, std::memory_order_release);
+	}
+	else
+	{
+		assert(b.position() == _header->head.load(std::memory_order_relaxed));
+		_header->head.store(b.position() + b.size(), std::memory_order_release);
+	}
+}
+
+template <typename T, bool MultipleProducers>
+bool basic_ring<T, MultipleProducers>::try_push(const T& record) noexcept
+{
+	const batch b = claim(1);
+	if (b.empty())
+		return false;
+
+	b[0] = record;
+	publish(b);
+	return true;
+}
+
+template <typename T, bool MultipleProducers>
+typename basic_ring<T, MultipleProducers>::batch basic_ring<T, MultipleProducers>::peek(std::size_t n) noexcept
+{
+	const std::uint64_t tail = _header->tail.load(std::memory_order_relaxed);
+
+	if constexpr (MultipleProducers)
+	{
+		// the batches may be published out of order: stop at the first record not published yet
+		std::size_t count = 0;
+		while (count < n && _slots[(tail + count) & _mask].sequence.load(std::memory_order_acquire) == tail + count + 1)
+			++count;
+		return batch(_slots, _mask, tail, count);
+	}
+	else
+	{
+		std::uint64_t available = _cached_head - tail;
+		if (available < n)
+		{
+			_cached_head = _header->head.load(std::memory_order_acquire);
+			available = _cached_head - tail;
+		}
+		return batch(_slots, _mask, tail, static_cast<std::size_t>(n < available ? n : available));
+	}
+}
+
+template <typename T, bool MultipleProducers>
+void basic_ring<T, MultipleProducers>::consume(std::size_t n) noexcept
+{
+	_header->tail.store(_header->tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+template <typename T, bool MultipleProducers>
+bool basic_ring<T, MultipleProducers>::try_pop(T& record) noexcept
+{
+	const batch b = peek(1);
+	if (b.empty())
+		return false;
+
+	record = b[0];
+	consume(1);
+	return true;
+}
+
+// Copies src into dst, which already holds a string, touching only the characters of both strings instead of the
+// N + 1 characters of the whole object. Correct because the characters past the terminator of dst are zero; worth it
+// for long strings written into ring records.
+template <std::size_t N, typename CharT, typename Traits>
+inline void copy_live_prefix(basic_inplace_string<N, CharT, Traits>& dst, const basic_inplace_string<N, CharT, Traits>& src) noexcept
+{
+	if constexpr (sizeof(dst) <= detail::ring_alignment)
+	{
+		dst = src;
+	}
+	else
+	{
+		const std::size_t size = src.size();
+		dst.resize(size);
+		Traits::copy(&dst[0], src.data(), size);
+	}
+}
+
+// Named block of memory shared between processes: POSIX shared memory object, or Windows file mapping backed by the
+// paging file. Unmapped on destruction.
+class shared_memory
+{
+public:
+	// Creates the segment, which must not exist, of size bytes initialized to zero
+	static shared_memory create(const std::string& name, std::size_t size);
+	static shared_memory open(const std::string& name);
+
+	// Removes the name, the memory being released once unmapped by all the processes. No-op on Windows, where the
+	// segment disappears with its last mapping.
+	static void remove(const std::string& name) noexcept;
+
+	shared_memory() = default;
+	~shared_memory() { unmap(); }
+
+	shared_memory(const shared_memory&) = delete;
+	shared_memory& operator=(const shared_memory&) = delete;
+
+	shared_memory(shared_memory&& other) noexcept { swap(other); }
+	shared_memory& operator=(shared_memory&& other) noexcept { swap(other); return *this; }
+
+	void* data() const noexcept       { return _data; }
+	std::size_t size() const noexcept { return _size; }
+
+	void swap(shared_memory& other) noexcept
+	{
+		std::swap(_data, other._data);
+		std::swap(_size, other._size);
+#if defined(_WIN32)
+		std::swap(_mapping, other._mapping);
+#endif
+	}
+
+private:
+	void unmap() noexcept;
+
+	void* _data = nullptr;
+	std::size_t _size = 0;
+#if defined(_WIN32)
+	HANDLE _mapping = nullptr;
+#endif
+};
+
+#if defined(_WIN32)
+
+inline shared_memory shared_memory::create(const std::string& name, std::size_t size)
+{
+	const std::uint64_t size64 = size;
+	HANDLE mapping = ::CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+										  static_cast<DWORD>(size64), name.c_str());
+	if (mapping == nullptr)
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot create " + name);
+	if (::GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		::CloseHandle(mapping);
+		detail::throw_helper<std::runtime_error>("shared_memory: " + name + " already exists");
+	}
+
+	void* p = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (p == nullptr)
+	{
+		::CloseHandle(mapping);
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot map " + name);
+	}
+
+	shared_memory shm;
+	shm._data = p;
+	shm._size = size;
+	shm._mapping = mapping;
+	return shm;
+}
+
+inline shared_memory shared_memory::open(const std::string& name)
+{
+	HANDLE mapping = ::OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+	if (mapping == nullptr)
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot open " + name);
+
+	void* p = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	MEMORY_BASIC_INFORMATION info;
+	if (p == nullptr || ::VirtualQuery(p, &info, sizeof(info)) == 0)
+	{
+		if (p != nullptr)
+			::UnmapViewOfFile(p);
+		::CloseHandle(mapping);
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot map " + name);
+	}
+
+	// rounded up to the page size
+	shared_memory shm;
+	shm._data = p;
+	shm._size = info.RegionSize;
+	shm._mapping = mapping;
+	return shm;
+}
+
+inline void shared_memory::remove(const std::string&) noexcept
+{
+}
+
+inline void shared_memory::unmap() noexcept
+{
+	if (_data != nullptr)
+		::UnmapViewOfFile(_data);
+	if (_mapping != nullptr)
+		::CloseHandle(_mapping);
+}
+
+#else
+
+inline shared_memory shared_memory::create(const std::string& name, std::size_t size)
+{
+	const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0)
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot create " + name);
+
+	if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+	{
+		::close(fd);
+		::shm_unlink(name.c_str());
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot resize " + name);
+	}
+
+	void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED)
+	{
+		::shm_unlink(name.c_str());
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot map " + name);
+	}
+
+	shared_memory shm;
+	shm._data = p;
+	shm._size = size;
+	return shm;
+}
+
+inline shared_memory shared_memory::open(const std::string& name)
+{
+	const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+	if (fd < 0)
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot open " + name);
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		::close(fd);
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot map " + name);
+	}
+
+	const std::size_t size = static_cast<std::size_t>(st.st_size);
+	void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED)
+		detail::throw_helper<std::runtime_error>("shared_memory: cannot map " + name);
+
+	shared_memory shm;
+	shm._data = p;
+	shm._size = size;
+	return shm;
+}
+
+inline void shared_memory::remove(const std::string& name) noexcept
+{
+	::shm_unlink(name.c_str());
+}
+
+inline void shared_memory::unmap() noexcept
+{
+	if (_data != nullptr)
+		::munmap(_data, _size);
+}
+
+#endif
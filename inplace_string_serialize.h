@@ -0,0 +1,188 @@
+#pragma once
+
+#include "inplace_string.h"
+
+// Binary serialization of basic_inplace_string into caller-provided buffers, e.g. for order state written to disk or
+// sent to replicas, without going through std::string. Two encodings:
+//
+//   compact   the size as a LEB128 varint (a single byte up to 127 characters), then the characters
+//   fixed     the N + 1 characters of the string as in memory, so that arrays of strings, and of trivially copyable
+//             structs holding them, are written and read with a single memcpy
+//
+//   std::vector<char> buffer(max_compact_size<inplace_string<15>>(symbols.size()));
+//   char* end = encode_compact(symbols.data(), symbols.data() + symbols.size(), buffer.data());
+//   ...
+//   if (!decode_compact(buffer.data(), end, symbols.data(), symbols.size()))
+//       // truncated or corrupted input
+//
+// Characters are written in the byte order of the writer. Decoding never throws: it returns nullptr on truncated input,
+// on a size above N, and, in fixed mode, on a string whose unused characters are not zero. The compact decoding leaves
+// the strings it rejects untouched; after a failed fixed decoding, the objects read must not be used.
+
+namespace detail
+{
+
+// Bytes of the LEB128 encoding of n
+constexpr std::size_t varint_size(std::uint64_t n) noexcept
+{
+	return n < 0x80 ? 1 : 1 + varint_size(n >> 7);
+}
+
+inline char* encode_varint(std::uint64_t n, char* out) noexcept
+{
+	while (n >= 0x80)
+	{
+		*out++ = static_cast<char>((n & 0x7F) | 0x80);
+		n >>= 7;
+	}
+	*out++ = static_cast<char>(n);
+	return out;
+}
+
+// Decodes at most max_bytes bytes, nullptr if the input ends first or the varint is longer
+inline const char* decode_varint(const char* first, const char* last, std::size_t max_bytes, std::uint64_t& n) noexcept
+{
+	n = 0;
+	for (std::size_t i = 0; i != max_bytes && first != last; ++i)
+	{
+		const unsigned char byte = static_cast<unsigned char>(*first++);
+		n |= std::uint64_t{byte & 0x7Fu} << (7 * i);
+		if (byte < 0x80)
+			return first;
+	}
+	return nullptr;
+}
+
+template <typename String>
+constexpr std::size_t serialized_capacity() noexcept
+{
+	return sizeof(String) / sizeof(typename String::value_type) - 1;
+}
+
+}
+
+// Checks the invariants of a string read from untrusted bytes: a size of at most N, and zero characters between the
+// terminator and the end of the string
+template <std::size_t N, typename CharT, typename Traits>
+bool is_well_formed(const basic_inplace_string<N, CharT, Traits>& str) noexcept
+{
+	const std::size_t size = str.size();
+	if (size > N)
+		return false;
+
+	CharT bits{};
+	for (std::size_t i = size; i != N; ++i)
+		bits = static_cast<CharT>(bits | str.data()[i]);
+	return bits == CharT{};
+}
+
+// Compact encoding
+
+// Bytes of the compact encoding of a string of N characters at most, and of count such strings. Buffers of this size
+// are required by the batch encode_compact, which copies whole strings and advances by their size.
+template <typename String>
+constexpr std::size_t max_compact_size(std::size_t count = 1) noexcept
+{
+	constexpr std::size_t n = detail::serialized_capacity<String>();
+	return count * (detail::varint_size(n) + n * sizeof(typename String::value_type));
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+std::size_t compact_size(const basic_inplace_string<N, CharT, Traits>& str) noexcept
+{
+	return detail::varint_size(str.size()) + str.size() * sizeof(CharT);
+}
+
+// Writes compact_size(str) bytes, returns the end of the encoding
+template <std::size_t N, typename CharT, typename Traits>
+char* encode_compact(const basic_inplace_string<N, CharT, Traits>& str, char* out) noexcept
+{
+	const std::size_t size = str.size();
+	out = detail::encode_varint(size, out);
+	std::memcpy(out, str.data(), size * sizeof(CharT));
+	return out + size * sizeof(CharT);
+}
+
+// Returns the end of the encoding, nullptr if the input is truncated or the size exceeds N
+template <std::size_t N, typename CharT, typename Traits>
+const char* decode_compact(const char* first, const char* last, basic_inplace_string<N, CharT, Traits>& str) noexcept
+{
+	std::uint64_t size;
+	first = detail::decode_varint(first, last, detail::varint_size(N), size);
+	if (first == nullptr || size > N || size * sizeof(CharT) > static_cast<std::size_t>(last - first))
+		return nullptr;
+
+	// resized from empty, so that the characters beyond the new size are zero
+	const std::size_t bytes = static_cast<std::size_t>(size) * sizeof(CharT);
+	str.clear();
+	str.resize(static_cast<std::size_t>(size));
+	std::memcpy(&str[0], first, bytes);
+	return first + bytes;
+}
+
+// Encodes [first, last) one after the other into max_compact_size<String>(last - first) bytes. Strings of up to 64
+// bytes are copied whole, a copy of constant size the compiler turns into a few vector moves, and the output advances
+// by their size only.
+template <std::size_t N, typename CharT, typename Traits>
+char* encode_compact(const basic_inplace_string<N, CharT, Traits>* first, const basic_inplace_string<N, CharT, Traits>* last,
+					 char* out) noexcept
+{
+	for (; first != last; ++first)
+	{
+		const std::size_t size = first->size();
+		out = detail::encode_varint(size, out);
+		std::memcpy(out, first->data(), (N * sizeof(CharT) <= 64 ? N : size) * sizeof(CharT));
+		out += size * sizeof(CharT);
+	}
+	return out;
+}
+
+// Decodes count strings, returns the end of the last encoding or nullptr on invalid input
+template <std::size_t N, typename CharT, typename Traits>
+const char* decode_compact(const char* first, const char* last, basic_inplace_string<N, CharT, Traits>* out, std::size_t count) noexcept
+{
+	for (std::size_t i = 0; i != count; ++i)
+	{
+		first = decode_compact(first, last, out[i]);
+		if (first == nullptr)
+			return nullptr;
+	}
+	return first;
+}
+
+// Fixed encoding
+
+// Writes the count objects as in memory, sizeof(T) * count bytes: strings, or trivially copyable structs holding them
+template <typename T>
+char* encode_fixed(const T* first, std::size_t count, char* out) noexcept
+{
+	static_assert(std::is_trivially_copyable<T>::value, "encode_fixed: objects must be trivially copyable");
+
+	std::memcpy(out, first, count * sizeof(T));
+	return out + count * sizeof(T);
+}
+
+// Reads count objects, each checked by validate (e.g. calling is_well_formed on every string member). Returns the end
+// of the encoding, nullptr if the input is truncated or an object is rejected.
+template <typename T, typename Validate>
+const char* decode_fixed(const char* first, const char* last, T* out, std::size_t count, Validate validate)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "decode_fixed: objects must be trivially copyable");
+
+	if (count > static_cast<std::size_t>(last - first) / sizeof(T))
+		return nullptr;
+
+	std::memcpy(out, first, count * sizeof(T));
+	for (std::size_t i = 0; i != count; ++i)
+	{
+		if (!validate(static_cast<const T&>(out[i])))
+			return nullptr;
+	}
+	return first + count * sizeof(T);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+const char* decode_fixed(const char* first, const char* last, basic_inplace_string<N, CharT, Traits>* out, std::size_t count) noexcept
+{
+	return decode_fixed(first, last, out, count, [](const basic_inplace_string<N, CharT, Traits>& str) { return is_well_formed(str); });
+}
@@ -0,0 +1,505 @@
+#pragma once
+
+#include "inplace_string_algorithm.h"
+
+// UTF-8 utilities for basic_inplace_string, e.g. for free-text fields received from clients:
+//
+//   inplace_string<63> text;
+//   if (assign_utf8(text, field) == utf_status::invalid)
+//       reject(...);
+//
+//   inplace_u16string<63> wide;
+//   transcode(text, wide);
+//
+// is_valid_utf8 checks well-formed UTF-8 as defined by Unicode (no overlong forms, surrogates or code points above
+// U+10FFFF). With AVX2 it classifies 32 bytes at a time from the nibbles of each byte and of its predecessor, with
+// table lookups (Keiser and Lemire, "Validating UTF-8 in less than one instruction per byte"); with SSE2 only, runs of
+// 16 ASCII bytes are skipped and the other sequences decoded one at a time. count_code_points counts the bytes that are
+// not continuation bytes, 16 at a time with SSE2.
+//
+// assign_utf8 and transcode cut a string longer than the capacity of the destination at the last complete code point
+// instead of splitting a multi-byte sequence or a surrogate pair, and leave the destination untouched on invalid input.
+// transcode converts between UTF-8, UTF-16 and UTF-32 strings (char, char16_t and char32_t), copying ASCII runs 16
+// bytes at a time from UTF-8.
+
+enum class utf_status
+{
+	ok,
+	truncated, // cut at a code point boundary to fit the destination
+	invalid
+};
+
+namespace detail
+{
+
+// Decodes the sequence at p, nullptr if it is not well-formed
+inline const unsigned char* decode_utf8(const unsigned char* p, const unsigned char* end, std::uint32_t& cp) noexcept
+{
+	const unsigned char lead = *p;
+	if (lead < 0x80)
+	{
+		cp = lead;
+		return p + 1;
+	}
+
+	std::size_t length;
+	std::uint32_t min;
+	if (lead >= 0xC2 && lead <= 0xDF)
+	{
+		length = 2;
+		min = 0x80;
+		cp = lead & 0x1Fu;
+	}
+	else if ((lead & 0xF0) == 0xE0)
+	{
+		length = 3;
+		min = 0x800;
+		cp = lead & 0x0Fu;
+	}
+	else if (lead >= 0xF0 && lead <= 0xF4)
+	{
+		length = 4;
+		min = 0x10000;
+		cp = lead & 0x07u;
+	}
+	else
+		return nullptr;
+
+	if (static_cast<std::size_t>(end - p) < length)
+		return nullptr;
+
+	for (std::size_t i = 1; i != length; ++i)
+	{
+		if ((p[i] & 0xC0) != 0x80)
+			return nullptr;
+		cp = (cp << 6) | (p[i] & 0x3Fu);
+	}
+
+	if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+		return nullptr;
+	return p + length;
+}
+
+#if defined(__AVX2__)
+
+// Error flags of a pair of bytes, looked up from the high nibble of the first, its low nibble and the high nibble of the
+// second: a pair is invalid when the three lookups share a flag
+struct utf8_lookup
+{
+	static constexpr std::uint8_t too_short = 1 << 0;      // 11______ 0_______, 11______ 11______
+	static constexpr std::uint8_t too_long = 1 << 1;       // 0_______ 10______
+	static constexpr std::uint8_t overlong_3 = 1 << 2;     // 11100000 100_____
+	static constexpr std::uint8_t too_large = 1 << 3;      // 11110100 1001____, 11110100 101_____, 11110101+
+	static constexpr std::uint8_t surrogate = 1 << 4;      // 11101101 101_____
+	static constexpr std::uint8_t overlong_2 = 1 << 5;     // 1100000_ 10______
+	static constexpr std::uint8_t too_large_1000 = 1 << 6; // 11110101+ 1000____
+	static constexpr std::uint8_t overlong_4 = 1 << 6;     // 11110000 1000____
+	static constexpr std::uint8_t two_conts = 1 << 7;      // 10______ 10______, unless expected by the lead byte
+	static constexpr std::uint8_t carry = too_short | too_long | two_conts;
+
+	static __m256i table(const std::uint8_t (&values)[16]) noexcept
+	{
+		return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values)));
+	}
+
+	static __m256i high_nibbles(__m256i v) noexcept { return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F)); }
+
+	// Bytes of the previous 32-byte block shifted in front of input
+	template <int K>
+	static __m256i previous(__m256i input, __m256i prev_input) noexcept
+	{
+		return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - K);
+	}
+};
+
+class utf8_checker
+{
+public:
+	utf8_checker() noexcept :
+		_byte_1_high(utf8_lookup::table(byte_1_high_values())),
+		_byte_1_low(utf8_lookup::table(byte_1_low_values())),
+		_byte_2_high(utf8_lookup::table(byte_2_high_values()))
+	{
+	}
+
+	void check(__m256i input) noexcept
+	{
+		if (_mm256_movemask_epi8(input) == 0)
+		{
+			// ASCII block: only a sequence left incomplete by the previous block is an error
+			_error = _mm256_or_si256(_error, _incomplete);
+			_incomplete = _mm256_setzero_si256();
+		}
+		else
+		{
+			const __m256i prev1 = utf8_lookup::previous<1>(input, _prev_input);
+			const __m256i special = _mm256_and_si256(
+				_mm256_and_si256(_mm256_shuffle_epi8(_byte_1_high, utf8_lookup::high_nibbles(prev1)),
+								 _mm256_shuffle_epi8(_byte_1_low, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+				_mm256_shuffle_epi8(_byte_2_high, utf8_lookup::high_nibbles(input)));
+
+			// third and fourth bytes of 3 and 4-byte sequences, which must be continuation bytes
+			const __m256i third = _mm256_subs_epu8(utf8_lookup::previous<2>(input, _prev_input), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+			const __m256i fourth = _mm256_subs_epu8(utf8_lookup::previous<3>(input, _prev_input), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+			const __m256i expected = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+			_error = _mm256_or_si256(_error, _mm256_xor_si256(expected, special));
+
+			// lead bytes in the last 3 positions that need more bytes than the block holds
+			const __m256i max_values = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+														-1, -1, -1, -1, -1, -1, -1, -1, static_cast<char>(0xF0 - 1),
+														static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+			_incomplete = _mm256_subs_epu8(input, max_values);
+		}
+		_prev_input = input;
+	}
+
+	bool valid() const noexcept
+	{
+		const __m256i error = _mm256_or_si256(_error, _incomplete);
+		return _mm256_testz_si256(error, error) != 0;
+	}
+
+private:
+	static const std::uint8_t (&byte_1_high_values())[16]
+	{
+		using l = utf8_lookup;
+		static const std::uint8_t values[16] = {
+			// 0_______: ASCII
+			l::too_long, l::too_long, l::too_long, l::too_long, l::too_long, l::too_long, l::too_long, l::too_long,
+			// 10______: continuation
+			l::two_conts, l::two_conts, l::two_conts, l::two_conts,
+			// 1100____, 1101____: 2-byte lead
+			l::too_short | l::overlong_2, l::too_short,
+			// 1110____: 3-byte lead
+			l::too_short | l::overlong_3 | l::surrogate,
+			// 1111____: 4-byte lead
+			l::too_short | l::too_large | l::too_large_1000 | l::overlong_4};
+		return values;
+	}
+
+	static const std::uint8_t (&byte_1_low_values())[16]
+	{
+		using l = utf8_lookup;
+		constexpr std::uint8_t large = l::carry | l::too_large | l::too_large_1000;
+		static const std::uint8_t values[16] = {
+			l::carry | l::overlong_3 | l::overlong_2 | l::overlong_4, // ____0000
+			l::carry | l::overlong_2,                                 // ____0001
+			l::carry, l::carry,                                       // ____001_
+			l::carry | l::too_large,                                  // ____0100
+			large, large, large,                                      // ____0101, ____011_
+			large, large, large, large, large,                        // ____1___
+			large | l::surrogate,                                     // ____1101
+			large, large};
+		return values;
+	}
+
+	static const std::uint8_t (&byte_2_high_values())[16]
+	{
+		using l = utf8_lookup;
+		static const std::uint8_t values[16] = {
+			// ________ 0_______: ASCII
+			l::too_short, l::too_short, l::too_short, l::too_short, l::too_short, l::too_short, l::too_short, l::too_short,
+			// ________ 1000____
+			l::too_long | l::overlong_2 | l::two_conts | l::overlong_3 | l::too_large_1000 | l::overlong_4,
+			// ________ 1001____
+			l::too_long | l::overlong_2 | l::two_conts | l::overlong_3 | l::too_large,
+			// ________ 101_____
+			l::too_long | l::overlong_2 | l::two_conts | l::surrogate | l::too_large,
+			l::too_long | l::overlong_2 | l::two_conts | l::surrogate | l::too_large,
+			// ________ 11______: lead
+			l::too_short, l::too_short, l::too_short, l::too_short};
+		return values;
+	}
+
+	__m256i _byte_1_high;
+	__m256i _byte_1_low;
+	__m256i _byte_2_high;
+	__m256i _error = _mm256_setzero_si256();
+	__m256i _prev_input = _mm256_setzero_si256();
+	__m256i _incomplete = _mm256_setzero_si256();
+};
+
+#endif
+
+inline std::uint32_t utf16_surrogate_pair(std::uint32_t high, std::uint32_t low) noexcept
+{
+	return 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+}
+
+// Decodes the code point at p, nullptr if it is not well-formed
+inline const char* next_code_point(const char* p, const char* end, std::uint32_t& cp) noexcept
+{
+	const unsigned char* first = reinterpret_cast<const unsigned char*>(p);
+	const unsigned char* last = decode_utf8(first, reinterpret_cast<const unsigned char*>(end), cp);
+	return last == nullptr ? nullptr : p + (last - first);
+}
+
+inline const char16_t* next_code_point(const char16_t* p, const char16_t* end, std::uint32_t& cp) noexcept
+{
+	cp = *p;
+	if (cp < 0xD800 || cp > 0xDFFF)
+		return p + 1;
+	if (cp > 0xDBFF || end - p < 2 || p[1] < 0xDC00 || p[1] > 0xDFFF)
+		return nullptr;
+	cp = utf16_surrogate_pair(cp, p[1]);
+	return p + 2;
+}
+
+inline const char32_t* next_code_point(const char32_t* p, const char32_t*, std::uint32_t& cp) noexcept
+{
+	cp = *p;
+	if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+		return nullptr;
+	return p + 1;
+}
+
+// Code units of cp
+inline std::size_t code_point_units(std::uint32_t cp, char) noexcept { return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4; }
+inline std::size_t code_point_units(std::uint32_t cp, char16_t) noexcept { return cp < 0x10000 ? 1 : 2; }
+inline std::size_t code_point_units(std::uint32_t, char32_t) noexcept { return 1; }
+
+inline void encode_code_point(std::uint32_t cp, char* out) noexcept
+{
+	if (cp < 0x80)
+	{
+		out[0] = static_cast<char>(cp);
+		return;
+	}
+
+	const std::size_t length = code_point_units(cp, char{});
+	static constexpr unsigned char leads[5] = {0, 0, 0xC0, 0xE0, 0xF0};
+	for (std::size_t i = length - 1; i != 0; --i)
+	{
+		out[i] = static_cast<char>(0x80 | (cp & 0x3F));
+		cp >>= 6;
+	}
+	out[0] = static_cast<char>(leads[length] | cp);
+}
+
+inline void encode_code_point(std::uint32_t cp, char16_t* out) noexcept
+{
+	if (cp < 0x10000)
+	{
+		out[0] = static_cast<char16_t>(cp);
+		return;
+	}
+	cp -= 0x10000;
+	out[0] = static_cast<char16_t>(0xD800 + (cp >> 10));
+	out[1] = static_cast<char16_t>(0xDC00 + (cp & 0x3FF));
+}
+
+inline void encode_code_point(std::uint32_t cp, char32_t* out) noexcept
+{
+	out[0] = static_cast<char32_t>(cp);
+}
+
+#if defined(INPLACE_STRING_SSE2)
+
+// Stores 16 ASCII characters
+inline void store_ascii(__m128i v, char* out) noexcept
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+}
+
+inline void store_ascii(__m128i v, char16_t* out) noexcept
+{
+	const __m128i zero = _mm_setzero_si128();
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(v, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(v, zero));
+}
+
+inline void store_ascii(__m128i v, char32_t* out) noexcept
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i low = _mm_unpacklo_epi8(v, zero);
+	const __m128i high = _mm_unpackhi_epi8(v, zero);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(low, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(low, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi16(high, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(high, zero));
+}
+
+#endif
+
+// Copies the run of ASCII characters at p, up to room characters, and returns their number
+template <typename To>
+std::size_t copy_ascii(const char*& p, const char* end, To* out, std::size_t room) noexcept
+{
+	std::size_t count = 0;
+#if defined(INPLACE_STRING_SSE2)
+	while (end - p >= 16 && room - count >= 16)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		if (_mm_movemask_epi8(v) != 0)
+			break;
+		store_ascii(v, out + count);
+		p += 16;
+		count += 16;
+	}
+#endif
+	for (; p != end && count != room && static_cast<unsigned char>(*p) < 0x80; ++p)
+		out[count++] = static_cast<To>(*p);
+	return count;
+}
+
+// No fast path from UTF-16 and UTF-32
+template <typename From, typename To>
+std::size_t copy_ascii(const From*&, const From*, To*, std::size_t) noexcept
+{
+	return 0;
+}
+
+template <typename CharT>
+struct is_utf_char : std::integral_constant<bool, std::is_same<CharT, char>::value || std::is_same<CharT, char16_t>::value ||
+												  std::is_same<CharT, char32_t>::value>
+{
+};
+
+}
+
+inline bool is_valid_utf8(const char* str, std::size_t size) noexcept
+{
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(str);
+	const unsigned char* end = p + size;
+
+#if defined(__AVX2__)
+	detail::utf8_checker checker;
+	for (; end - p >= 32; p += 32)
+		checker.check(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+
+	if (p != end)
+	{
+		// the zeros that follow the last bytes reveal a sequence they leave incomplete
+		alignas(32) unsigned char block[32] = {};
+		std::memcpy(block, p, static_cast<std::size_t>(end - p));
+		checker.check(_mm256_load_si256(reinterpret_cast<const __m256i*>(block)));
+	}
+	return checker.valid();
+#else
+	while (p != end)
+	{
+#if defined(INPLACE_STRING_SSE2)
+		while (end - p >= 16 && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) == 0)
+			p += 16;
+		if (p == end)
+			break;
+#endif
+		std::uint32_t cp;
+		p = detail::decode_utf8(p, end, cp);
+		if (p == nullptr)
+			return false;
+	}
+	return true;
+#endif
+}
+
+template <std::size_t N, typename Traits>
+bool is_valid_utf8(const basic_inplace_string<N, char, Traits>& str) noexcept
+{
+	return is_valid_utf8(str.data(), str.size());
+}
+
+// Number of code points of valid UTF-8
+inline std::size_t count_code_points(const char* str, std::size_t size) noexcept
+{
+	std::size_t count = 0;
+	std::size_t i = 0;
+
+#if defined(INPLACE_STRING_SSE2)
+	// bytes above -65 as signed, i.e. not continuation bytes, accumulated by byte before their counters overflow
+	const __m128i continuation_max = _mm_set1_epi8(-65);
+	while (size - i >= 16)
+	{
+		__m128i counters = _mm_setzero_si128();
+		for (std::size_t block = 0; block != 255 && size - i >= 16; ++block, i += 16)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+			counters = _mm_sub_epi8(counters, _mm_cmpgt_epi8(v, continuation_max));
+		}
+		const __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+		count += static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) + static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
+	}
+#endif
+
+	for (; i != size; ++i)
+		count += (static_cast<unsigned char>(str[i]) & 0xC0) != 0x80;
+	return count;
+}
+
+template <std::size_t N, typename Traits>
+std::size_t count_code_points(const basic_inplace_string<N, char, Traits>& str) noexcept
+{
+	return count_code_points(str.data(), str.size());
+}
+
+// Largest prefix of at most max bytes that does not end inside a multi-byte sequence
+inline std::size_t utf8_prefix_size(const char* str, std::size_t size, std::size_t max) noexcept
+{
+	if (size <= max)
+		return size;
+
+	// backs up to the lead byte of the sequence holding str[max], at most 3 bytes before
+	std::size_t i = max;
+	while (i != 0 && i + 3 > max && (static_cast<unsigned char>(str[i]) & 0xC0) == 0x80)
+		--i;
+	return (static_cast<unsigned char>(str[i]) & 0xC0) == 0x80 ? max : i;
+}
+
+// Assigns the longest prefix of [s, s + count) that fits, or leaves str untouched if that prefix is not valid UTF-8
+template <std::size_t N, typename Traits>
+utf_status assign_utf8(basic_inplace_string<N, char, Traits>& str, const char* s, std::size_t count) noexcept
+{
+	const std::size_t size = utf8_prefix_size(s, count, N);
+	if (!is_valid_utf8(s, size))
+		return utf_status::invalid;
+
+	str = basic_inplace_string<N, char, Traits>(s, size);
+	return size == count ? utf_status::ok : utf_status::truncated;
+}
+
+template <std::size_t N, typename Traits, typename T,
+		  typename X = typename std::enable_if<std::is_convertible<const T&, basic_string_view<char, Traits>>::value>::type>
+utf_status assign_utf8(basic_inplace_string<N, char, Traits>& str, const T& t) noexcept
+{
+	const basic_string_view<char, Traits> sv = t;
+	return assign_utf8(str, sv.data(), sv.size());
+}
+
+// Converts between UTF-8, UTF-16 and UTF-32. When dst is too small, the code points that fit are kept and the rest of
+// src is not checked. dst is left untouched on invalid input.
+template <std::size_t N, typename From, typename FromTraits, std::size_t M, typename To, typename ToTraits>
+utf_status transcode(const basic_inplace_string<N, From, FromTraits>& src, basic_inplace_string<M, To, ToTraits>& dst) noexcept
+{
+	static_assert(detail::is_utf_char<From>::value && detail::is_utf_char<To>::value, "transcode: strings of char, char16_t or char32_t");
+
+	To buffer[M];
+	std::size_t count = 0;
+	utf_status status = utf_status::ok;
+
+	const From* p = src.data();
+	const From* end = p + src.size();
+	while (p != end)
+	{
+		count += detail::copy_ascii(p, end, buffer + count, M - count);
+		if (p == end)
+			break;
+
+		std::uint32_t cp;
+		const From* next = detail::next_code_point(p, end, cp);
+		if (next == nullptr)
+			return utf_status::invalid;
+
+		const std::size_t units = detail::code_point_units(cp, To{});
+		if (count + units > M)
+		{
+			status = utf_status::truncated;
+			break;
+		}
+		detail::encode_code_point(cp, buffer + count);
+		count += units;
+		p = next;
+	}
+
+	dst = basic_inplace_string<M, To, ToTraits>(buffer, count);
+	return status;
+}
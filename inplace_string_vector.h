@@ -0,0 +1,332 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+
+// Vector of basic_inplace_string relying on the strings being trivially relocatable: the storage grows with realloc,
+// and insertions and erasures shift the elements with a single memmove.
+template <
+	std::size_t N,
+	typename CharT = char,
+	typename Traits = std::char_traits<CharT>>
+class basic_inplace_string_vector
+{
+public:
+	using value_type = basic_inplace_string<N, CharT, Traits>;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using pointer = value_type*;
+	using const_pointer = const value_type*;
+	using iterator = pointer;
+	using const_iterator = const_pointer;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	static_assert(is_trivially_relocatable<value_type>::value, "basic_inplace_string must be trivially relocatable");
+
+	basic_inplace_string_vector() noexcept = default;
+	explicit basic_inplace_string_vector(size_type count) { resize(count); }
+	basic_inplace_string_vector(size_type count, const value_type& value) { resize(count, value); }
+	basic_inplace_string_vector(std::initializer_list<value_type> ilist) { insert(end(), ilist.begin(), ilist.end()); }
+
+	template <typename InputIt, typename X = typename std::enable_if<detail::is_input_iterator<InputIt>::value>::type>
+	basic_inplace_string_vector(InputIt first, InputIt last) { insert(end(), first, last); }
+
+	basic_inplace_string_vector(const basic_inplace_string_vector& other);
+	basic_inplace_string_vector(basic_inplace_string_vector&& other) noexcept { swap(other); }
+
+	basic_inplace_string_vector& operator=(const basic_inplace_string_vector& other);
+	basic_inplace_string_vector& operator=(basic_inplace_string_vector&& other) noexcept { swap(other); return *this; }
+
+	~basic_inplace_string_vector() { std::free(_data); }
+
+	reference       at(size_type i);
+	const_reference at(size_type i) const;
+
+	reference       operator[](size_type i)       { assert(i < size()); return _data[i]; }
+	const_reference operator[](size_type i) const { assert(i < size()); return _data[i]; }
+
+	reference       front()       { assert(!empty()); return _data[0]; }
+	const_reference front() const { assert(!empty()); return _data[0]; }
+	reference       back()        { assert(!empty()); return _data[_size - 1]; }
+	const_reference back() const  { assert(!empty()); return _data[_size - 1]; }
+
+	pointer       data() noexcept       { return _data; }
+	const_pointer data() const noexcept { return _data; }
+
+	iterator       begin() noexcept        { return _data; }
+	const_iterator begin() const noexcept  { return _data; }
+	const_iterator cbegin() const noexcept { return _data; }
+	iterator       end() noexcept          { return _data + _size; }
+	const_iterator end() const noexcept    { return _data + _size; }
+	const_iterator cend() const noexcept   { return _data + _size; }
+
+	reverse_iterator       rbegin() noexcept        { return reverse_iterator(end()); }
+	const_reverse_iterator rbegin() const noexcept  { return const_reverse_iterator(end()); }
+	reverse_iterator       rend() noexcept          { return reverse_iterator(begin()); }
+	const_reverse_iterator rend() const noexcept    { return const_reverse_iterator(begin()); }
+
+	bool empty() const noexcept        { return _size == 0; }
+	size_type size() const noexcept     { return _size; }
+	size_type capacity() const noexcept { return _capacity; }
+
+	void reserve(size_type new_cap);
+	void shrink_to_fit();
+
+	void clear() noexcept { _size = 0; }
+
+	void resize(size_type count) { resize(count, value_type{}); }
+	void resize(size_type count, const value_type& value);
+
+	// Resizes without initializing the new elements, for parsers filling the storage directly: each of them must be
+	// assigned, or entirely written with the N + 1 characters of a valid string, before being read.
+	void resize_uninitialized(size_type count);
+
+	void push_back(const value_type& value);
+	template <typename... Args>
+	reference emplace_back(Args&&... args);
+	void pop_back() { assert(!empty()); --_size; }
+
+	iterator insert(const_iterator pos, const value_type& value) { return insert(pos, size_type{1}, value); }
+	iterator insert(const_iterator pos, size_type count, const value_type& value);
+	iterator insert(const_iterator pos, std::initializer_list<value_type> ilist) { return insert(pos, ilist.begin(), ilist.end()); }
+
+	template <typename InputIt, typename X = typename std::enable_if<detail::is_input_iterator<InputIt>::value>::type>
+	iterator insert(const_iterator pos, InputIt first, InputIt last);
+
+	iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+	iterator erase(const_iterator first, const_iterator last);
+
+	void swap(basic_inplace_string_vector& other) noexcept;
+
+private:
+	// Opens a gap of count uninitialized elements at index
+	pointer make_gap(size_type index, size_type count);
+	void reallocate(size_type new_cap);
+	size_type grow_capacity(size_type min_cap) const noexcept { return std::max(min_cap, 2 * _capacity); }
+
+	pointer _data = nullptr;
+	size_type _size = 0;
+	size_type _capacity = 0;
+};
+
+template <std::size_t N, typename CharT, typename Traits>
+basic_inplace_string_vector<N, CharT, Traits>::basic_inplace_string_vector(const basic_inplace_string_vector& other)
+{
+	resize_uninitialized(other.size());
+	if (!other.empty())
+		std::memcpy(static_cast<void*>(_data), other._data, other.size() * sizeof(value_type));
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+basic_inplace_string_vector<N, CharT, Traits>&
+basic_inplace_string_vector<N, CharT, Traits>::operator=(const basic_inplace_string_vector& other)
+{
+	if (this != &other)
+	{
+		resize_uninitialized(other.size());
+		if (!other.empty())
+			std::memcpy(static_cast<void*>(_data), other._data, other.size() * sizeof(value_type));
+	}
+	return *this;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_inplace_string_vector<N, CharT, Traits>::reference
+basic_inplace_string_vector<N, CharT, Traits>::at(size_type i)
+{
+	if (i >= size())
+		detail::throw_helper<std::out_of_range>("basic_inplace_string_vector::at: out of range");
+
+	return _data[i];
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_inplace_string_vector<N, CharT, Traits>::const_reference
+basic_inplace_string_vector<N, CharT, Traits>::at(size_type i) const
+{
+	if (i >= size())
+		detail::throw_helper<std::out_of_range>("basic_inplace_string_vector::at: out of range");
+
+	return _data[i];
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_vector<N, CharT, Traits>::reallocate(size_type new_cap)
+{
+	assert(new_cap >= _size);
+
+	if (new_cap > std::numeric_limits<size_type>::max() / sizeof(value_type))
+		detail::throw_helper<std::length_error>("basic_inplace_string_vector: exceed maximum size");
+
+	if (new_cap == 0)
+	{
+		std::free(_data);
+		_data = nullptr;
+		_capacity = 0;
+		return;
+	}
+
+	void* p = std::realloc(static_cast<void*>(_data), new_cap * sizeof(value_type));
+	if (p == nullptr)
+		detail::throw_helper<std::bad_alloc>("basic_inplace_string_vector: out of memory");
+
+	_data = static_cast<pointer>(p);
+	_capacity = new_cap;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_vector<N, CharT, Traits>::reserve(size_type new_cap)
+{
+	if (new_cap > _capacity)
+		reallocate(new_cap);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_vector<N, CharT, Traits>::shrink_to_fit()
+{
+	if (_size < _capacity)
+		reallocate(_size);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_vector<N, CharT, Traits>::resize(size_type count, const value_type& value)
+{
+	const size_type sz = _size;
+	resize_uninitialized(count);
+
+	if (count > sz)
+		std::uninitialized_fill(_data + sz, _data + count, value);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_vector<N, CharT, Traits>::resize_uninitialized(size_type count)
+{
+	if (count > _capacity)
+		reallocate(grow_capacity(count));
+
+	_size = count;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_vector<N, CharT, Traits>::push_back(const value_type& value)
+{
+	if (_size == _capacity)
+	{
+		// value may belong to this vector
+		const value_type copy = value;
+		reallocate(grow_capacity(_size + 1));
+		_data[_size++] = copy;
+	}
+	else
+	{
+		_data[_size++] = value;
+	}
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+template <typename... Args>
+typename basic_inplace_string_vector<N, CharT, Traits>::reference
+basic_inplace_string_vector<N, CharT, Traits>::emplace_back(Args&&... args)
+{
+	const value_type value(std::forward<Args>(args)...);
+	push_back(value);
+	return back();
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_inplace_string_vector<N, CharT, Traits>::pointer
+basic_inplace_string_vector<N, CharT, Traits>::make_gap(size_type index, size_type count)
+{
+	assert(index <= _size);
+
+	if (count == 0)
+		return _data + index;
+
+	if (_size + count > _capacity)
+		reallocate(grow_capacity(_size + count));
+
+	std::memmove(static_cast<void*>(_data + index + count), _data + index, (_size - index) * sizeof(value_type));
+	_size += count;
+	return _data + index;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_inplace_string_vector<N, CharT, Traits>::iterator
+basic_inplace_string_vector<N, CharT, Traits>::insert(const_iterator pos, size_type count, const value_type& value)
+{
+	const value_type copy = value;
+	const size_type index = static_cast<size_type>(pos - _data);
+
+	pointer gap = make_gap(index, count);
+	std::uninitialized_fill(gap, gap + count, copy);
+	return gap;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+template <typename InputIt, typename X>
+typename basic_inplace_string_vector<N, CharT, Traits>::iterator
+basic_inplace_string_vector<N, CharT, Traits>::insert(const_iterator pos, InputIt first, InputIt last)
+{
+	const size_type index = static_cast<size_type>(pos - _data);
+
+	if (detail::is_forward_iterator<InputIt>::value)
+	{
+		// the range must not alias this vector, as for std::vector
+		const size_type count = static_cast<size_type>(std::distance(first, last));
+		pointer gap = make_gap(index, count);
+		std::uninitialized_copy(first, last, gap);
+	}
+	else
+	{
+		const size_type sz = _size;
+		for (; first != last; ++first)
+			emplace_back(*first);
+		std::rotate(_data + index, _data + sz, _data + _size);
+	}
+
+	return _data + index;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+typename basic_inplace_string_vector<N, CharT, Traits>::iterator
+basic_inplace_string_vector<N, CharT, Traits>::erase(const_iterator first, const_iterator last)
+{
+	const size_type index = static_cast<size_type>(first - _data);
+	const size_type count = static_cast<size_type>(last - first);
+
+	if (count == 0)
+		return _data + index;
+
+	std::memmove(static_cast<void*>(_data + index), _data + index + count, (_size - index - count) * sizeof(value_type));
+	_size -= count;
+	return _data + index;
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+void basic_inplace_string_vector<N, CharT, Traits>::swap(basic_inplace_string_vector& other) noexcept
+{
+	std::swap(_data, other._data);
+	std::swap(_size, other._size);
+	std::swap(_capacity, other._capacity);
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+inline bool operator==(const basic_inplace_string_vector<N, CharT, Traits>& lhs, const basic_inplace_string_vector<N, CharT, Traits>& rhs)
+{
+	return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <std::size_t N, typename CharT, typename Traits>
+inline bool operator!=(const basic_inplace_string_vector<N, CharT, Traits>& lhs, const basic_inplace_string_vector<N, CharT, Traits>& rhs)
+{
+	return !(lhs == rhs);
+}
+
+template <std::size_t N> using inplace_string_vector = basic_inplace_string_vector<N, char>;
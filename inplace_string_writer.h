@@ -0,0 +1,261 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <cerrno>
+#include <memory>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// Writes many strings to a file descriptor with few system calls, e.g. the fields of an audit log, without the virtual
+// calls and locale of std::ostream:
+//
+//   vectored_writer out(fd);
+//   for (const order& o : orders)
+//       out << o.id << ',' << o.symbol << ',' << o.account << '\n';
+//   out.flush();
+//
+// The pieces are gathered into an array of iovec, written with writev() when the array or the buffer is full, on
+// flush() and on destruction. Pieces of at least copy_threshold characters are referenced, not copied: they must stay
+// valid until the next flush(). Shorter pieces (separators, short fields) are copied and coalesced into a single
+// buffer, so that consecutive short pieces take a single iovec. Temporary strings are always copied, or written at once
+// when longer than the buffer; a string_view of a temporary is still referenced. Without writev (Windows), each iovec is
+// written in turn.
+
+namespace detail
+{
+
+#if defined(_WIN32)
+struct io_vector
+{
+	void* iov_base;
+	std::size_t iov_len;
+};
+#else
+using io_vector = ::iovec;
+#endif
+
+// Writes all the pieces, throws std::runtime_error on error
+inline void write_vectors(int fd, io_vector* pieces, std::size_t count)
+{
+	while (count != 0)
+	{
+#if defined(_WIN32)
+		const unsigned int size = static_cast<unsigned int>(pieces->iov_len < 0x40000000 ? pieces->iov_len : 0x40000000);
+		const int n = ::_write(fd, pieces->iov_base, size);
+#else
+		const ssize_t n = ::writev(fd, pieces, static_cast<int>(count));
+#endif
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			detail::throw_helper<std::runtime_error>("vectored_writer: cannot write");
+		}
+
+		// skips the pieces written, and the part written of the last one
+		std::size_t written = static_cast<std::size_t>(n);
+		while (count != 0 && written >= pieces->iov_len)
+		{
+			written -= pieces->iov_len;
+			++pieces;
+			--count;
+		}
+		if (count != 0)
+		{
+			pieces->iov_base = static_cast<char*>(pieces->iov_base) + written;
+			pieces->iov_len -= written;
+		}
+	}
+}
+
+}
+
+class vectored_writer
+{
+public:
+	static constexpr std::size_t max_pieces = 256;
+	static constexpr std::size_t copy_threshold = 128;
+	static constexpr std::size_t default_buffer_size = 1 << 16;
+
+	// The file descriptor is not closed by the writer
+	explicit vectored_writer(int fd, std::size_t buffer_size = default_buffer_size);
+
+	// Flushes, ignoring errors
+	~vectored_writer();
+
+	vectored_writer(const vectored_writer&) = delete;
+	vectored_writer& operator=(const vectored_writer&) = delete;
+
+	vectored_writer& write(const char* str, std::size_t count);
+	vectored_writer& put(char ch);
+
+	// Writes the pieces gathered so far. Throws std::runtime_error on error.
+	void flush();
+
+	// Characters gathered and not written yet
+	std::size_t pending() const noexcept { return _pending; }
+
+	template <std::size_t N, typename Traits>
+	vectored_writer& operator<<(const basic_inplace_string<N, char, Traits>& str) { return write(str.data(), str.size()); }
+
+	template <std::size_t N, typename Traits>
+	vectored_writer& operator<<(basic_inplace_string<N, char, Traits>&& str) { return write_temporary(str.data(), str.size()); }
+
+	template <typename Traits>
+	vectored_writer& operator<<(basic_string_view<char, Traits> str) { return write(str.data(), str.size()); }
+
+	template <typename Traits, typename Allocator>
+	vectored_writer& operator<<(const std::basic_string<char, Traits, Allocator>& str) { return write(str.data(), str.size()); }
+
+	template <typename Traits, typename Allocator>
+	vectored_writer& operator<<(std::basic_string<char, Traits, Allocator>&& str) { return write_temporary(str.data(), str.size()); }
+
+	// String literals and character arrays, up to their first '\0' as with std::ostream, copied when short as any other
+	// piece. The search is folded for literals.
+	template <std::size_t M>
+	vectored_writer& operator<<(const char (&str)[M])
+	{
+		const char* end = std::char_traits<char>::find(str, M, '\0');
+		return write(str, end != nullptr ? static_cast<std::size_t>(end - str) : M);
+	}
+
+	vectored_writer& operator<<(char ch) { return put(ch); }
+
+private:
+	// Copies a short piece at the end of the buffer, in the last iovec if it ends there
+	void copy(const char* str, std::size_t count);
+
+	// Writes a piece that does not outlive the call: copied, or written now if longer than the buffer
+	vectored_writer& write_temporary(const char* str, std::size_t count);
+
+	int _fd;
+	std::unique_ptr<char[]> _buffer;
+	std::size_t _buffer_size;
+	std::size_t _used = 0;
+	std::size_t _pending = 0;
+
+	detail::io_vector _pieces[max_pieces];
+	std::size_t _count = 0;
+	bool _last_copied = false; // the last iovec ends at the end of the buffer
+};
+
+inline vectored_writer::vectored_writer(int fd, std::size_t buffer_size) :
+	_fd(fd),
+	_buffer_size(buffer_size)
+{
+	if (buffer_size < copy_threshold)
+		detail::throw_helper<std::invalid_argument>("vectored_writer: buffer smaller than the copy threshold");
+
+	_buffer.reset(new char[buffer_size]);
+}
+
+inline vectored_writer::~vectored_writer()
+{
+#ifndef _NO_EXCEPTIONS
+	try
+	{
+		flush();
+	}
+	catch (const std::runtime_error&)
+	{
+	}
+#else
+	flush();
+#endif
+}
+
+inline vectored_writer& vectored_writer::write(const char* str, std::size_t count)
+{
+	if (count == 0)
+		return *this;
+
+	if (count < copy_threshold)
+	{
+		copy(str, count);
+		return *this;
+	}
+
+	if (_count == max_pieces)
+		flush();
+
+	_pieces[_count].iov_base = const_cast<char*>(str);
+	_pieces[_count].iov_len = count;
+	++_count;
+	_pending += count;
+	_last_copied = false;
+	return *this;
+}
+
+inline vectored_writer& vectored_writer::put(char ch)
+{
+	// fast path: appended to the last iovec, which ends at the end of the buffer
+	if (_last_copied && _used != _buffer_size)
+	{
+		_buffer[_used++] = ch;
+		++_pieces[_count - 1].iov_len;
+		++_pending;
+		return *this;
+	}
+
+	copy(&ch, 1);
+	return *this;
+}
+
+inline void vectored_writer::copy(const char* str, std::size_t count)
+{
+	if (_used + count > _buffer_size)
+		flush();
+
+	if (!_last_copied && _count == max_pieces)
+		flush();
+
+	char* p = _buffer.get() + _used;
+	std::memcpy(p, str, count);
+	_used += count;
+	_pending += count;
+
+	if (_last_copied)
+	{
+		_pieces[_count - 1].iov_len += count;
+	}
+	else
+	{
+		_pieces[_count].iov_base = p;
+		_pieces[_count].iov_len = count;
+		++_count;
+		_last_copied = true;
+	}
+}
+
+inline vectored_writer& vectored_writer::write_temporary(const char* str, std::size_t count)
+{
+	if (count <= _buffer_size)
+	{
+		if (count != 0)
+			copy(str, count);
+		return *this;
+	}
+
+	write(str, count);
+	flush();
+	return *this;
+}
+
+inline void vectored_writer::flush()
+{
+	if (_count != 0)
+	{
+		const std::size_t count = _count;
+		_count = 0;
+		_used = 0;
+		_pending = 0;
+		_last_copied = false;
+		detail::write_vectors(_fd, _pieces, count);
+	}
+}
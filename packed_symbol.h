@@ -0,0 +1,267 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <functional>
+
+// Set of characters a packed_symbol can hold, e.g. symbol_alphabet<'A', 'B', 'C'>. The characters must be sorted by
+// their unsigned value: packed symbols then compare like the strings they encode.
+template <char... Chars>
+struct symbol_alphabet
+{
+	static constexpr std::size_t size = sizeof...(Chars);
+	static constexpr char characters[sizeof...(Chars)] = {Chars...};
+};
+
+// [-./0-9A-Z]: 39 characters, 12 per 64-bit word
+using ticker_alphabet = symbol_alphabet<
+	'-', '.', '/',
+	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+	'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+	'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z'>;
+
+namespace detail
+{
+
+// Each character is a digit in base (alphabet size + 1), digit 0 being the padding after the end of the string.
+template <typename Alphabet>
+struct packed_symbol_tables
+{
+	static_assert(Alphabet::size > 0 && Alphabet::size < 128, "packed_symbol: alphabet must hold between 1 and 127 characters");
+
+	static constexpr std::uint64_t radix = Alphabet::size + 1;
+	static constexpr std::uint8_t invalid = 0x80;
+
+	static constexpr bool is_valid()
+	{
+		if (Alphabet::characters[0] == '\0')
+			return false;
+
+		for (std::size_t i = 1; i < Alphabet::size; ++i)
+			if (static_cast<unsigned char>(Alphabet::characters[i - 1]) >= static_cast<unsigned char>(Alphabet::characters[i]))
+				return false;
+		return true;
+	}
+
+	static_assert(is_valid(), "packed_symbol: alphabet must be sorted, without duplicates nor '\\0'");
+
+	static constexpr std::size_t make_digits_per_word()
+	{
+		const std::uint64_t max = std::numeric_limits<std::uint64_t>::max();
+
+		std::uint64_t largest = 0;
+		std::size_t digits = 0;
+		while (largest <= (max - (radix - 1)) / radix)
+		{
+			largest = largest * radix + (radix - 1);
+			++digits;
+		}
+		return digits;
+	}
+
+	static constexpr std::array<std::uint8_t, 256> make_codes()
+	{
+		std::array<std::uint8_t, 256> codes{};
+		for (std::size_t i = 1; i < codes.size(); ++i)
+			codes[i] = invalid;
+
+		for (std::size_t i = 0; i < Alphabet::size; ++i)
+			codes[static_cast<unsigned char>(Alphabet::characters[i])] = static_cast<std::uint8_t>(i + 1);
+		return codes;
+	}
+
+	static constexpr std::array<char, radix> make_characters()
+	{
+		std::array<char, radix> characters{};
+		for (std::size_t i = 0; i < Alphabet::size; ++i)
+			characters[i + 1] = Alphabet::characters[i];
+		return characters;
+	}
+
+	static constexpr std::size_t digits_per_word = make_digits_per_word();
+	static constexpr std::array<std::uint8_t, 256> codes = make_codes();
+	static constexpr std::array<char, radix> characters = make_characters();
+};
+
+}
+
+// Order-preserving encoding of an inplace_string<N> restricted to a small alphabet: each character is stored as a digit
+// in base (Alphabet::size + 1), packed in as many 64-bit words as required (10 characters of a 63-character alphabet,
+// 12 of ticker_alphabet per word). Equality, hashing and ordering are then plain integer operations.
+template <std::size_t N, typename Alphabet = ticker_alphabet>
+class packed_symbol
+{
+	using tables = detail::packed_symbol_tables<Alphabet>;
+
+public:
+	using string_type = basic_inplace_string<N, char>;
+
+	static constexpr std::size_t digits_per_word = tables::digits_per_word;
+	static constexpr std::size_t word_count = (N + digits_per_word - 1) / digits_per_word;
+
+	using words_type = std::array<std::uint64_t, word_count>;
+
+	packed_symbol() noexcept : _words{} {}
+
+	explicit packed_symbol(const string_type& str);
+	explicit packed_symbol(basic_string_view<char, std::char_traits<char>> sv) : packed_symbol(string_type(sv)) {}
+
+	static packed_symbol from_words(const words_type& words) noexcept;
+
+	const words_type& words() const noexcept { return _words; }
+
+	string_type str() const;
+
+	// Encodes [first, last) into out, stops at the first string holding a character outside of the alphabet and
+	// returns a pointer to it (last if all have been encoded). Both loops are branch-free over the N characters.
+	static const string_type* encode(const string_type* first, const string_type* last, packed_symbol* out) noexcept;
+	static void decode(const packed_symbol* first, const packed_symbol* last, string_type* out) noexcept;
+
+private:
+	static bool encode(const string_type& str, words_type& words) noexcept;
+	static void decode(const words_type& words, string_type& str) noexcept;
+
+	words_type _words;
+};
+
+template <std::size_t N, typename Alphabet>
+packed_symbol<N, Alphabet>::packed_symbol(const string_type& str)
+{
+	if (!encode(str, _words))
+		detail::throw_helper<std::invalid_argument>("packed_symbol: character not part of the alphabet");
+}
+
+template <std::size_t N, typename Alphabet>
+packed_symbol<N, Alphabet> packed_symbol<N, Alphabet>::from_words(const words_type& words) noexcept
+{
+	packed_symbol symbol;
+	symbol._words = words;
+	return symbol;
+}
+
+template <std::size_t N, typename Alphabet>
+typename packed_symbol<N, Alphabet>::string_type packed_symbol<N, Alphabet>::str() const
+{
+	string_type str;
+	decode(_words, str);
+	return str;
+}
+
+template <std::size_t N, typename Alphabet>
+const typename packed_symbol<N, Alphabet>::string_type*
+packed_symbol<N, Alphabet>::encode(const string_type* first, const string_type* last, packed_symbol* out) noexcept
+{
+	for (; first != last; ++first, ++out)
+		if (!encode(*first, out->_words))
+			return first;
+	return last;
+}
+
+template <std::size_t N, typename Alphabet>
+void packed_symbol<N, Alphabet>::decode(const packed_symbol* first, const packed_symbol* last, string_type* out) noexcept
+{
+	for (; first != last; ++first, ++out)
+		decode(first->_words, *out);
+}
+
+template <std::size_t N, typename Alphabet>
+bool packed_symbol<N, Alphabet>::encode(const string_type& str, words_type& words) noexcept
+{
+	// the characters past the terminator are zero and encode as padding: no need to look at the size
+	const char* data = str.data();
+	std::uint8_t flags = 0;
+	std::size_t non_padding = 0;
+
+	for (std::size_t w = 0; w < word_count; ++w)
+	{
+		std::uint64_t v = 0;
+		for (std::size_t d = 0; d < digits_per_word; ++d)
+		{
+			const std::size_t i = w * digits_per_word + d;
+			const std::uint8_t code = i < N ? tables::codes[static_cast<unsigned char>(data[i])] : std::uint8_t{0};
+
+			flags |= code;
+			non_padding += code != 0;
+			v = v * tables::radix + static_cast<std::uint8_t>(code & ~tables::invalid);
+		}
+		words[w] = v;
+	}
+
+	// an embedded '\0' would be encoded as padding
+	return (flags & tables::invalid) == 0 && non_padding == str.size();
+}
+
+template <std::size_t N, typename Alphabet>
+void packed_symbol<N, Alphabet>::decode(const words_type& words, string_type& str) noexcept
+{
+	std::array<char, word_count * digits_per_word> chars;
+	std::size_t size = 0;
+
+	for (std::size_t w = 0; w < word_count; ++w)
+	{
+		std::uint64_t v = words[w];
+		for (std::size_t d = digits_per_word; d-- > 0;)
+		{
+			const std::uint64_t code = v % tables::radix;
+			v /= tables::radix;
+
+			chars[w * digits_per_word + d] = tables::characters[code];
+			size += code != 0;
+		}
+	}
+
+	str = string_type(chars.data(), std::min(size, N));
+}
+
+template <std::size_t N, typename Alphabet>
+inline bool operator==(const packed_symbol<N, Alphabet>& lhs, const packed_symbol<N, Alphabet>& rhs) noexcept
+{
+	return lhs.words() == rhs.words();
+}
+
+template <std::size_t N, typename Alphabet>
+inline bool operator!=(const packed_symbol<N, Alphabet>& lhs, const packed_symbol<N, Alphabet>& rhs) noexcept
+{
+	return lhs.words() != rhs.words();
+}
+
+template <std::size_t N, typename Alphabet>
+inline bool operator<(const packed_symbol<N, Alphabet>& lhs, const packed_symbol<N, Alphabet>& rhs) noexcept
+{
+	return lhs.words() < rhs.words();
+}
+
+template <std::size_t N, typename Alphabet>
+inline bool operator>(const packed_symbol<N, Alphabet>& lhs, const packed_symbol<N, Alphabet>& rhs) noexcept
+{
+	return rhs < lhs;
+}
+
+template <std::size_t N, typename Alphabet>
+inline bool operator<=(const packed_symbol<N, Alphabet>& lhs, const packed_symbol<N, Alphabet>& rhs) noexcept
+{
+	return !(rhs < lhs);
+}
+
+template <std::size_t N, typename Alphabet>
+inline bool operator>=(const packed_symbol<N, Alphabet>& lhs, const packed_symbol<N, Alphabet>& rhs) noexcept
+{
+	return !(lhs < rhs);
+}
+
+namespace std
+{
+
+template <std::size_t N, typename Alphabet>
+struct hash<packed_symbol<N, Alphabet>>
+{
+	size_t operator()(const packed_symbol<N, Alphabet>& symbol) const noexcept
+	{
+		std::uint64_t h = 0;
+		for (std::uint64_t w : symbol.words())
+			h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+		return detail::mix_uint64(h);
+	}
+};
+
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "inplace_string.h"
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+// Append-only storage for the characters of long umbra_strings. Strings stay valid until the arena is destroyed.
+class string_arena
+{
+public:
+	explicit string_arena(std::size_t chunk_size = 64 * 1024) :
+		_chunk_size(chunk_size)
+	{}
+
+	const char* store(const char* str, std::size_t count)
+	{
+		if (count > _remaining)
+		{
+			const std::size_t sz = std::max(count, _chunk_size);
+			_chunks.emplace_back(new char[sz]);
+			_current = _chunks.back().get();
+			_remaining = sz;
+		}
+
+		char* p = _current;
+		std::memcpy(p, str, count);
+		_current += count;
+		_remaining -= count;
+		return p;
+	}
+
+private:
+	std::vector<std::unique_ptr<char[]>> _chunks;
+	char* _current = nullptr;
+	std::size_t _remaining = 0;
+	std::size_t _chunk_size;
+};
+
+// 16-byte string made of a 32-bit size, the first 4 characters, and either the next 8 characters or a pointer to the
+// whole string stored in a string_arena. Strings of up to 12 characters are stored inline, and most comparisons are
+// resolved on the size and prefix without following the pointer. Meant as the column type next to
+// basic_inplace_string when both short and long strings are expected.
+class umbra_string
+{
+public:
+	using traits_type = std::char_traits<char>;
+	using value_type = char;
+	using size_type = std::size_t;
+	using const_pointer = const char*;
+	using const_iterator = const char*;
+
+	static constexpr const size_type prefix_size = 4;
+	static constexpr const size_type inline_capacity = 12;
+
+	umbra_string() noexcept :
+		_size(0),
+		_data{}
+	{}
+
+	template <std::size_t N, typename Traits>
+	umbra_string(const basic_inplace_string<N, char, Traits>& str) noexcept;
+
+	umbra_string(basic_string_view<char, traits_type> sv, string_arena& arena);
+
+	template <std::size_t N, typename Traits>
+	umbra_string(const basic_inplace_string<N, char, Traits>& str, string_arena& arena) :
+		umbra_string(basic_string_view<char, traits_type>(str.data(), str.size()), arena)
+	{}
+
+	size_type size() const noexcept   { return _size; }
+	size_type length() const noexcept { return _size; }
+	bool empty() const noexcept       { return _size == 0; }
+	bool is_inline() const noexcept   { return _size <= inline_capacity; }
+
+	const char* data() const noexcept { return is_inline() ? _data : pointer(); }
+
+	const_iterator begin() const noexcept { return data(); }
+	const_iterator end() const noexcept   { return data() + size(); }
+
+	basic_string_view<char, traits_type> prefix() const noexcept { return {_data, std::min<size_type>(_size, prefix_size)}; }
+
+	operator basic_string_view<char, traits_type>() const noexcept { return {data(), size()}; }
+
+	template <std::size_t N>
+	basic_inplace_string<N, char> to_inplace_string() const { return basic_inplace_string<N, char>(data(), size()); }
+
+	int compare(const umbra_string& other) const noexcept;
+
+	friend bool operator==(const umbra_string& lhs, const umbra_string& rhs) noexcept;
+
+private:
+	std::uint64_t head() const noexcept
+	{
+		std::uint64_t v;
+		std::memcpy(&v, this, sizeof(v));
+		return v;
+	}
+
+	std::uint64_t tail() const noexcept
+	{
+		std::uint64_t v;
+		std::memcpy(&v, _data + prefix_size, sizeof(v));
+		return v;
+	}
+
+	const char* pointer() const noexcept
+	{
+		const char* p;
+		std::memcpy(&p, _data + prefix_size, sizeof(p));
+		return p;
+	}
+
+	void set_pointer(const char* p) noexcept
+	{
+		std::memcpy(_data + prefix_size, &p, sizeof(p));
+	}
+
+	// the prefix, followed by either the next 8 characters or the pointer to the whole string
+	std::uint32_t _size;
+	char _data[inline_capacity];
+};
+
+static_assert(sizeof(umbra_string) == 16, "umbra_string must be 16 bytes");
+
+template <std::size_t N, typename Traits>
+umbra_string::umbra_string(const basic_inplace_string<N, char, Traits>& str) noexcept :
+	umbra_string()
+{
+	static_assert(N <= inline_capacity, "umbra_string: strings longer than 12 characters require a string_arena");
+
+	_size = static_cast<std::uint32_t>(str.size());
+	std::memcpy(_data, str.data(), str.size());
+}
+
+inline umbra_string::umbra_string(basic_string_view<char, traits_type> sv, string_arena& arena) :
+	umbra_string()
+{
+	if (sv.size() > std::numeric_limits<std::uint32_t>::max())
+		detail::throw_helper<std::length_error>("umbra_string: exceed maximum string length");
+
+	_size = static_cast<std::uint32_t>(sv.size());
+
+	if (is_inline())
+	{
+		std::memcpy(_data, sv.data(), sv.size());
+	}
+	else
+	{
+		std::memcpy(_data, sv.data(), prefix_size);
+		set_pointer(arena.store(sv.data(), sv.size()));
+	}
+}
+
+inline int umbra_string::compare(const umbra_string& other) const noexcept
+{
+	// the prefixes are zero-padded: a difference is always a difference in the strings themselves
+	const int cmp = std::memcmp(_data, other._data, prefix_size);
+	if (cmp != 0)
+		return cmp;
+
+	const size_type sz = std::min(size(), other.size());
+	if (sz > prefix_size)
+	{
+		const int rest = traits_type::compare(data() + prefix_size, other.data() + prefix_size, sz - prefix_size);
+		if (rest != 0)
+			return rest;
+	}
+	return size() > other.size() ? 1 : (size() == other.size() ? 0 : -1);
+}
+
+inline bool operator==(const umbra_string& lhs, const umbra_string& rhs) noexcept
+{
+	if (lhs.head() != rhs.head())
+		return false;
+
+	if (lhs.is_inline())
+		return lhs.tail() == rhs.tail();
+
+	const char* l = lhs.pointer();
+	const char* r = rhs.pointer();
+	return l == r || std::memcmp(l + umbra_string::prefix_size, r + umbra_string::prefix_size, lhs.size() - umbra_string::prefix_size) == 0;
+}
+
+inline bool operator!=(const umbra_string& lhs, const umbra_string& rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
+inline bool operator<(const umbra_string& lhs, const umbra_string& rhs) noexcept
+{
+	return lhs.compare(rhs) < 0;
+}
+
+inline bool operator>(const umbra_string& lhs, const umbra_string& rhs) noexcept
+{
+	return rhs < lhs;
+}
+
+inline bool operator<=(const umbra_string& lhs, const umbra_string& rhs) noexcept
+{
+	return !(rhs < lhs);
+}
+
+inline bool operator>=(const umbra_string& lhs, const umbra_string& rhs) noexcept
+{
+	return !(lhs < rhs);
+}
+
+inline std::ostream& operator<<(std::ostream& os, const umbra_string& str)
+{
+	return os.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+namespace std
+{
+
+template <>
+struct hash<umbra_string>
+{
+	size_t operator()(const umbra_string& str) const noexcept
+	{
+		using view = basic_string_view<char, std::char_traits<char>>;
+		return std::hash<view>()(view(str.data(), str.size()));
+	}
+};
+
+}
@@ -1,8 +1,35 @@
 #include "inplace_string.h"
+#include "atomic_inplace_string.h"
+#include "concurrent_inplace_string_map.h"
+#include "dictionary_column.h"
+#include "fixed_string.h"
+#include "front_coded_set.h"
+#include "inplace_flat_map.h"
+#include "inplace_string_algorithm.h"
+#include "inplace_string_column.h"
+#include "inplace_string_csv.h"
+#include "inplace_string_file.h"
+#include "inplace_string_ingest.h"
+#include "inplace_string_match.h"
+#include "inplace_string_reader.h"
+#include "inplace_string_ring.h"
+#include "inplace_string_serialize.h"
+#include "inplace_string_utf8.h"
+#include "inplace_string_vector.h"
+#include "inplace_string_writer.h"
+#include "packed_symbol.h"
+#include "umbra_string.h"
 
 #include <gtest/gtest.h>
 
 #include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <random>
+#include <unordered_set>
+#include <vector>
 
 using my_string = inplace_string<31>;
 
@@ -1250,3 +1277,1905 @@ TEST(inplace_string, find)
 	EXPECT_EQ(npos, s.find('b', 4));
 }
 
+
+TEST(inplace_string, zeroed_tail)
+{
+	auto tail_is_zero = [](const my_string& s)
+	{
+		for (std::size_t i = s.size(); i < my_string::max_size(); ++i)
+			if (s.data()[i] != '\0')
+				return false;
+		return true;
+	};
+
+	my_string s("foobarfoobar");
+	s.erase(3, 3);
+	EXPECT_TRUE(tail_is_zero(s));
+
+	s.resize(2);
+	EXPECT_TRUE(tail_is_zero(s));
+
+	s = "foobarfoobar";
+	s.replace(0, 6, "z");
+	EXPECT_EQ("zfoobar", s);
+	EXPECT_TRUE(tail_is_zero(s));
+
+	s = "foobarfoobar";
+	s.replace(s.cbegin(), s.cbegin() + 6, 2, 'z');
+	EXPECT_EQ("zzfoobar", s);
+	EXPECT_TRUE(tail_is_zero(s));
+
+	s.pop_back();
+	EXPECT_TRUE(tail_is_zero(s));
+
+	EXPECT_TRUE(tail_is_zero(my_string(3, 'z')));
+	EXPECT_TRUE(tail_is_zero(my_string(std::string("foobar"))));
+}
+
+TEST(inplace_string, as_uint64)
+{
+	using short_string = inplace_string<7>;
+	static_assert(sizeof(short_string) == sizeof(std::uint64_t), "");
+
+	short_string s1("foobar");
+	short_string s2("foobarz");
+	s2.pop_back();
+	EXPECT_EQ(s1.as_uint64(), s2.as_uint64());
+
+	s2.erase(0, 1);
+	EXPECT_NE(s1.as_uint64(), s2.as_uint64());
+
+	EXPECT_EQ(short_string().as_uint64(), short_string("foo").substr(3).as_uint64());
+	EXPECT_EQ(inplace_string<3>("foo").as_uint64(), inplace_string<3>("fooz", 3).as_uint64());
+}
+
+TEST(inplace_string, as_uint128)
+{
+	using short_string = inplace_string<15>;
+	static_assert(sizeof(short_string) == 2 * sizeof(std::uint64_t), "");
+
+	short_string s1("foobarfoobar");
+	short_string s2("foobarfoobarzzz");
+	s2.resize(12);
+	EXPECT_EQ(s1.as_uint128(), s2.as_uint128());
+
+	s2.back() = 'R';
+	EXPECT_NE(s1.as_uint128(), s2.as_uint128());
+}
+
+TEST(inplace_string, integer_comparators)
+{
+	auto check = [](const auto& strings)
+	{
+		const inplace_string_integer_less less;
+		const inplace_string_integer_equal equal;
+		const inplace_string_integer_hash hash;
+
+		for (const auto& lhs : strings)
+			for (const auto& rhs : strings)
+			{
+				EXPECT_EQ(lhs < rhs, less(lhs, rhs)) << lhs << " < " << rhs;
+				EXPECT_EQ(lhs == rhs, equal(lhs, rhs)) << lhs << " == " << rhs;
+				if (lhs == rhs)
+				{
+					EXPECT_EQ(hash(lhs), hash(rhs));
+				}
+			}
+	};
+
+	const char with_nul[] = {'a', 'b', '\0'};
+	using str7 = inplace_string<7>;
+	using str15 = inplace_string<15>;
+	using str3 = inplace_string<3>;
+
+	check(std::vector<str7>{"", "a", "ab", str7(with_nul, 3), "abc", "b", "\xff", "zzzzzzz", "zzzzzz"});
+	check(std::vector<str15>{"", "a", "ab", str15(with_nul, 3), "abc", "b", "\xff", "foobarfoo", "foobarfo", "foobarfoobarfoo", "foobarfoobarfoz"});
+	check(std::vector<str3>{"", "a", "ab", str3(with_nul, 3), "abc", "b", "\xff"});
+
+	std::unordered_set<str15, inplace_string_integer_hash, inplace_string_integer_equal> set{"foo", "bar", "foo"};
+	EXPECT_EQ(2, set.size());
+	EXPECT_EQ(1, set.count("bar"));
+}
+
+TEST(packed_symbol, encode)
+{
+	using symbol = packed_symbol<12>;
+	static_assert(symbol::digits_per_word == 12, "");
+	static_assert(sizeof(symbol) == sizeof(std::uint64_t), "");
+
+	EXPECT_EQ("", symbol().str());
+	EXPECT_EQ("", symbol(symbol::string_type()).str());
+	EXPECT_EQ("BRK.B", symbol(symbol::string_type("BRK.B")).str());
+	EXPECT_EQ("ZZZZZZZZZZZZ", symbol(symbol::string_type("ZZZZZZZZZZZZ")).str());
+	EXPECT_EQ("ESZ6-ESH7", symbol(string_view("ESZ6-ESH7")).str());
+
+	EXPECT_THROW(symbol(symbol::string_type("brk")), std::invalid_argument);
+	EXPECT_THROW(symbol(symbol::string_type("A\0B", 3)), std::invalid_argument);
+	EXPECT_THROW(symbol(string_view("ZZZZZZZZZZZZZ")), std::length_error);
+
+	EXPECT_EQ(symbol(string_view("IBM")), symbol::from_words(symbol(string_view("IBM")).words()));
+}
+
+TEST(packed_symbol, multiple_words)
+{
+	using symbol = packed_symbol<30>;
+	static_assert(symbol::word_count == 3, "");
+
+	const std::string str = "SPXW261016C05800000.P-ABCDEFGH";
+	EXPECT_EQ(str, std::string(symbol(string_view(str)).str()));
+	EXPECT_EQ("SPXW", symbol(string_view("SPXW")).str());
+}
+
+TEST(packed_symbol, ordering)
+{
+	using symbol = packed_symbol<15>;
+	const std::vector<std::string> strings = {"", "A", "AA", "AAAAAAAAAAAAA", "AAAAAAAAAAAAB", "AB", "B", "B.A", "BA", "Z", "-", "9", "ZZZZZZZZZZZZZZZ"};
+
+	for (const std::string& lhs : strings)
+		for (const std::string& rhs : strings)
+		{
+			const symbol l{string_view(lhs)};
+			const symbol r{string_view(rhs)};
+			EXPECT_EQ(lhs < rhs, l < r) << lhs << " < " << rhs;
+			EXPECT_EQ(lhs == rhs, l == r) << lhs << " == " << rhs;
+			EXPECT_EQ(lhs == rhs, std::hash<symbol>()(l) == std::hash<symbol>()(r)) << lhs << " == " << rhs;
+		}
+}
+
+TEST(packed_symbol, batch)
+{
+	using symbol = packed_symbol<10, symbol_alphabet<'A', 'B', 'C'>>;
+	using string = symbol::string_type;
+
+	const std::vector<string> strings = {"A", "ABC", "", "CCCCCCCCCC", "BA"};
+	std::vector<symbol> symbols(strings.size());
+	EXPECT_EQ(strings.data() + strings.size(), symbol::encode(strings.data(), strings.data() + strings.size(), symbols.data()));
+
+	std::vector<string> decoded(strings.size());
+	symbol::decode(symbols.data(), symbols.data() + symbols.size(), decoded.data());
+	EXPECT_EQ(strings, decoded);
+
+	const std::vector<string> invalid = {"A", "ABD", "B"};
+	EXPECT_EQ(invalid.data() + 1, symbol::encode(invalid.data(), invalid.data() + invalid.size(), symbols.data()));
+}
+
+TEST(umbra_string, construct)
+{
+	string_arena arena;
+
+	umbra_string empty;
+	EXPECT_TRUE(empty.empty());
+	EXPECT_EQ(0, empty.size());
+
+	umbra_string s1(inplace_string<12>("foobarfoobar"));
+	EXPECT_TRUE(s1.is_inline());
+	EXPECT_EQ("foobarfoobar", string_view(s1));
+	EXPECT_EQ("foob", s1.prefix());
+
+	umbra_string s2(my_string("foobarfoobarfoobar"), arena);
+	EXPECT_FALSE(s2.is_inline());
+	EXPECT_EQ(18, s2.size());
+	EXPECT_EQ("foobarfoobarfoobar", string_view(s2));
+	EXPECT_EQ("foob", s2.prefix());
+
+	umbra_string s3(string_view("foo"), arena);
+	EXPECT_TRUE(s3.is_inline());
+	EXPECT_EQ("foo", s3.prefix());
+
+	EXPECT_EQ(my_string("foobarfoobarfoobar"), s2.to_inplace_string<31>());
+	EXPECT_EQ(my_string("foobarfoobarfoobar"), my_string(s2));
+	EXPECT_THROW(s2.to_inplace_string<15>(), std::length_error);
+}
+
+TEST(umbra_string, compare)
+{
+	string_arena arena(16);
+
+	const char with_nul[] = {'a', 'b', '\0'};
+	const std::vector<std::string> strings = {"", "a", "ab", std::string(with_nul, 3), "abc", "abcd", "abcde", "abcdefghijkl",
+											  "abcdefghijklm", "abcdefghijkz", "abcdefghijklmnopqrstuvwxyz", "abcz", "b", "\xff"};
+
+	std::vector<umbra_string> umbras;
+	for (const std::string& str : strings)
+		umbras.emplace_back(string_view(str), arena);
+
+	for (std::size_t i = 0; i < strings.size(); ++i)
+		for (std::size_t j = 0; j < strings.size(); ++j)
+		{
+			EXPECT_EQ(strings[i] < strings[j], umbras[i] < umbras[j]) << strings[i] << " < " << strings[j];
+			EXPECT_EQ(strings[i] == strings[j], umbras[i] == umbras[j]) << strings[i] << " == " << strings[j];
+
+			const umbra_string copy(string_view(strings[j]), arena);
+			EXPECT_EQ(strings[i] == strings[j], umbras[i] == copy) << strings[i] << " == " << strings[j];
+		}
+
+	EXPECT_EQ(std::hash<string_view>()("abcdefghijklm"), std::hash<umbra_string>()(umbras[8]));
+}
+
+TEST(inplace_flat_set, find)
+{
+	using set = inplace_flat_set<31>;
+
+	set empty;
+	EXPECT_EQ(empty.end(), empty.find("foo"));
+	EXPECT_EQ(empty.end(), empty.lower_bound("foo"));
+
+	set s{"foobar", "foo", "SPXW 261016C", "SPXW 261016P", "SPXW 261016C5800", "foo", "zzz", ""};
+	EXPECT_EQ(7, s.size());
+	EXPECT_TRUE(std::is_sorted(s.begin(), s.end()));
+
+	for (const auto& key : s)
+	{
+		EXPECT_EQ(key, *s.find(key));
+		EXPECT_EQ(key, *s.find(string_view(key)));
+		EXPECT_EQ(key, *s.find(std::string(key).c_str()));
+	}
+
+	EXPECT_TRUE(s.contains("SPXW 261016C5800"));
+	EXPECT_FALSE(s.contains("SPXW 261016C58"));
+	EXPECT_FALSE(s.contains("SPXW 261016"));
+	EXPECT_EQ(0, s.count("fo"));
+
+	EXPECT_EQ("SPXW 261016C", *s.lower_bound("SPXW 261016"));
+	EXPECT_EQ("SPXW 261016P", *s.lower_bound("SPXW 261016D"));
+	EXPECT_EQ("foo", *s.lower_bound("SPXW 261016Z"));
+	EXPECT_EQ(s.end(), s.lower_bound("zzzz"));
+	EXPECT_EQ(s.begin(), s.lower_bound(""));
+}
+
+TEST(inplace_flat_set, lower_bound)
+{
+	std::vector<inplace_string<7>> keys;
+	for (int i = 0; i < 1000; i += 3)
+		keys.emplace_back(std::to_string(i));
+
+	inplace_flat_set<7> s(keys);
+	std::sort(keys.begin(), keys.end());
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		const std::string key = std::to_string(i);
+		EXPECT_EQ(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin(), s.lower_bound(key) - s.begin()) << key;
+	}
+}
+
+TEST(inplace_flat_map, find)
+{
+	using map = inplace_flat_map<15, int>;
+
+	map m{{"foo", 1}, {"bar", 2}, {"foobarfoobar", 3}, {"foobarfoobaz", 4}, {"foo", 5}};
+	EXPECT_EQ(4, m.size());
+
+	EXPECT_EQ(1, m.at("foo"));
+	EXPECT_EQ(2, m.at(string_view("bar")));
+	EXPECT_EQ(3, m.at(inplace_string<15>("foobarfoobar")));
+	EXPECT_EQ(4, m.find("foobarfoobaz")->second);
+	EXPECT_EQ(m.end(), m.find("foobarfooba"));
+	EXPECT_THROW(m.at("baz"), std::out_of_range);
+}
+
+namespace
+{
+
+template <std::size_t N>
+void test_find_in()
+{
+	using string = inplace_string<N>;
+
+	std::vector<string> strings;
+	for (int i = 0; i < 150; ++i)
+		strings.emplace_back(std::to_string(i * 7919 % 1000));
+	strings.emplace_back(std::string(N, 'z'));
+
+	const string* first = strings.data();
+	const string* last = first + strings.size();
+
+	for (const string& key : strings)
+		EXPECT_EQ(std::find(first, last, key), find_in(first, last, key)) << key;
+
+	EXPECT_EQ(last, find_in(first, last, string("foo")));
+	EXPECT_EQ(first, find_in(first, first, string("foo")));
+
+	// same characters but different sizes
+	string shorter = strings[1];
+	shorter.pop_back();
+	EXPECT_EQ(std::find(first, last, shorter), find_in(first, last, shorter));
+
+	for (std::size_t count = 0; count <= 64; ++count)
+	{
+		std::uint64_t expected = 0;
+		for (std::size_t i = 0; i < count; ++i)
+			if (strings[i] == strings[3])
+				expected |= std::uint64_t{1} << i;
+		EXPECT_EQ(expected, match_mask(first, first + count, strings[3])) << count;
+	}
+}
+
+}
+
+TEST(inplace_string_algorithm, find_in)
+{
+	test_find_in<3>();
+	test_find_in<7>();
+	test_find_in<15>();
+	test_find_in<31>();
+	test_find_in<63>();
+	test_find_in<10>();
+}
+
+TEST(inplace_string_algorithm, radix_sort)
+{
+	using string = inplace_string<15>;
+
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<int> size_dist(0, 15);
+	std::uniform_int_distribution<int> char_dist(0, 3);
+
+	// few distinct characters, '\\0' and '\\xff' included, to get many common prefixes
+	const char chars[] = {'\0', 'a', 'b', '\xff'};
+	auto make_strings = [&](std::size_t count)
+	{
+		std::vector<string> strings(count);
+		for (string& str : strings)
+		{
+			const int size = size_dist(gen);
+			for (int i = 0; i < size; ++i)
+				str.push_back(chars[char_dist(gen)]);
+		}
+		return strings;
+	};
+
+	for (std::size_t count : {0, 1, 2, 63, 64, 65, 1000, 100000})
+		for (unsigned threads : {1, 4})
+		{
+			std::vector<string> strings = make_strings(count);
+			std::vector<string> expected = strings;
+			std::sort(expected.begin(), expected.end());
+
+			radix_sort(strings.data(), strings.data() + strings.size(), threads);
+			EXPECT_EQ(expected, strings) << count << " " << threads;
+		}
+}
+
+namespace
+{
+
+template <std::size_t N>
+void test_network_sort()
+{
+	using string = inplace_string<N>;
+
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<std::size_t> size_dist(0, N);
+	std::uniform_int_distribution<int> char_dist(0, 3);
+	const char chars[] = {'\0', 'a', 'b', '\xff'};
+
+	for (std::size_t count = 0; count <= 64; ++count)
+	{
+		std::vector<string> strings(count);
+		for (string& str : strings)
+		{
+			const std::size_t size = size_dist(gen);
+			for (std::size_t i = 0; i < size; ++i)
+				str.push_back(chars[char_dist(gen)]);
+		}
+
+		std::vector<string> expected = strings;
+		std::stable_sort(expected.begin(), expected.end());
+
+		std::vector<std::uint8_t> indices(count);
+		network_sort_indices(strings.data(), strings.data() + count, indices.data());
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			EXPECT_EQ(expected[i], strings[indices[i]]);
+			if (i > 0 && strings[indices[i - 1]] == strings[indices[i]])
+			{
+				EXPECT_LT(indices[i - 1], indices[i]);
+			}
+		}
+
+		std::vector<string> sorted = strings;
+		network_sort(sorted.data(), sorted.data() + count);
+		EXPECT_EQ(expected, sorted) << count;
+
+		expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+		std::vector<string> unique = strings;
+		unique.erase(network_sort_unique(unique.data(), unique.data() + count) - unique.data() + unique.begin(), unique.end());
+		EXPECT_EQ(expected, unique) << count;
+	}
+}
+
+}
+
+TEST(inplace_string_algorithm, network_sort)
+{
+	test_network_sort<2>();
+	test_network_sort<7>();
+	test_network_sort<11>();
+	test_network_sort<15>();
+}
+
+TEST(inplace_string, trivially_relocatable)
+{
+	static_assert(std::is_trivially_copyable<my_string>::value, "");
+	static_assert(std::is_trivially_destructible<my_string>::value, "");
+	static_assert(is_trivially_relocatable<my_string>::value, "");
+	static_assert(is_trivially_relocatable<inplace_u32string<7>>::value, "");
+	static_assert(sizeof(inplace_u32string<7>) == 32, "");
+}
+
+TEST(inplace_string_vector, modifiers)
+{
+	using vector = inplace_string_vector<15>;
+
+	vector v;
+	EXPECT_TRUE(v.empty());
+
+	v.push_back("foo");
+	v.emplace_back("bar");
+	v.emplace_back(3, 'z');
+	EXPECT_EQ(3, v.size());
+	EXPECT_EQ("foo", v[0]);
+	EXPECT_EQ("bar", v[1]);
+	EXPECT_EQ("zzz", v.back());
+
+	for (int i = 0; i < 100; ++i)
+		v.push_back(v[1]);
+	EXPECT_EQ(103, v.size());
+	EXPECT_EQ("bar", v.back());
+
+	v.erase(v.begin() + 2, v.end());
+	EXPECT_EQ((vector{"foo", "bar"}), v);
+
+	v.insert(v.begin() + 1, "baz");
+	EXPECT_EQ((vector{"foo", "baz", "bar"}), v);
+
+	v.insert(v.begin(), 2, "a");
+	EXPECT_EQ((vector{"a", "a", "foo", "baz", "bar"}), v);
+
+	const std::vector<inplace_string<15>> other = {"x", "y"};
+	v.insert(v.end() - 1, other.begin(), other.end());
+	EXPECT_EQ((vector{"a", "a", "foo", "baz", "x", "y", "bar"}), v);
+
+	std::istringstream iss("s t");
+	v.insert(v.begin() + 1, std::istream_iterator<std::string>(iss), std::istream_iterator<std::string>());
+	EXPECT_EQ((vector{"a", "s", "t", "a", "foo", "baz", "x", "y", "bar"}), v);
+
+	v.erase(v.begin());
+	v.pop_back();
+	EXPECT_EQ((vector{"s", "t", "a", "foo", "baz", "x", "y"}), v);
+
+	EXPECT_THROW(v.at(7), std::out_of_range);
+
+	vector copy = v;
+	EXPECT_EQ(v, copy);
+	vector moved = std::move(copy);
+	EXPECT_EQ(v, moved);
+	EXPECT_TRUE(copy.empty());
+
+	v.clear();
+	EXPECT_TRUE(v.empty());
+	v.shrink_to_fit();
+	EXPECT_EQ(0, v.capacity());
+}
+
+TEST(inplace_string_vector, resize)
+{
+	inplace_string_vector<7> v(2);
+	EXPECT_EQ(2, v.size());
+	EXPECT_TRUE(v[1].empty());
+
+	v.resize(4, "foo");
+	EXPECT_EQ("foo", v[3]);
+
+	// e.g. records read from a file
+	const char records[] = "bar\0\0\0\0\x04" "foobar\0\x01";
+	v.resize_uninitialized(6);
+	std::memcpy(static_cast<void*>(v.data() + 4), records, 2 * sizeof(inplace_string<7>));
+	EXPECT_EQ("bar", v[4]);
+	EXPECT_EQ("foobar", v[5]);
+
+	v.resize(1);
+	EXPECT_EQ(1, v.size());
+	EXPECT_GE(v.capacity(), 6);
+}
+
+TEST(inplace_string_column, access)
+{
+	inplace_string_column<7> column{"foo", "", "foobar", "bar"};
+	EXPECT_EQ(4, column.size());
+	EXPECT_EQ("foobar", column[2]);
+	EXPECT_EQ("", column[1]);
+	EXPECT_EQ(inplace_string<7>("bar"), column.get(3));
+	EXPECT_THROW(column.at(4), std::out_of_range);
+
+	EXPECT_EQ(0, std::memcmp(column.row(0), "foo\0\0\0\0", 7));
+	EXPECT_EQ(6, column.sizes()[2]);
+
+	column.set(2, "ba");
+	EXPECT_EQ(0, std::memcmp(column.row(2), "ba\0\0\0\0\0", 7));
+	EXPECT_THROW(column.set(2, "foobarba"), std::length_error);
+	EXPECT_THROW(column.push_back("foobarba"), std::length_error);
+
+	const std::vector<std::string> expected = {"foo", "", "ba", "bar"};
+	EXPECT_TRUE(std::equal(column.begin(), column.end(), expected.begin(), expected.end()));
+
+	const std::vector<inplace_string<7>> strings = {"a", "b"};
+	inplace_string_column<7> other(strings.begin(), strings.end());
+	other.pop_back();
+	EXPECT_EQ(1, other.size());
+	EXPECT_EQ("a", other[0]);
+}
+
+TEST(inplace_string_column, scans)
+{
+	const inplace_string_column<7> column{"foo", "", "foobar", "bar", "fo"};
+	std::vector<std::uint8_t> mask(column.size());
+
+	column.size_between(2, 3, mask.data());
+	EXPECT_EQ((std::vector<std::uint8_t>{1, 0, 0, 1, 1}), mask);
+
+	column.size_between(0, 100, mask.data());
+	EXPECT_EQ((std::vector<std::uint8_t>{1, 1, 1, 1, 1}), mask);
+
+	column.size_between(8, 100, mask.data());
+	EXPECT_EQ((std::vector<std::uint8_t>{0, 0, 0, 0, 0}), mask);
+
+	column.starts_with("foo", mask.data());
+	EXPECT_EQ((std::vector<std::uint8_t>{1, 0, 1, 0, 0}), mask);
+
+	column.starts_with("", mask.data());
+	EXPECT_EQ((std::vector<std::uint8_t>{1, 1, 1, 1, 1}), mask);
+
+	column.starts_with("foobarba", mask.data());
+	EXPECT_EQ((std::vector<std::uint8_t>{0, 0, 0, 0, 0}), mask);
+}
+
+template <std::size_t N>
+static void test_hash_batch()
+{
+	std::vector<inplace_string<N>> strings;
+	for (std::size_t i = 0; i < 21; ++i)
+		strings.emplace_back(std::to_string(i * 7919).substr(0, N));
+
+	std::vector<std::size_t> hashes(strings.size());
+	hash_batch(strings.data(), strings.data() + strings.size(), hashes.data());
+	for (std::size_t i = 0; i < strings.size(); ++i)
+		EXPECT_EQ(std::hash<inplace_string<N>>()(strings[i]), hashes[i]);
+
+	hash_batch(strings.data(), strings.data() + strings.size(), hashes.data(), inplace_string_integer_hash{});
+	for (std::size_t i = 0; i < strings.size(); ++i)
+		EXPECT_EQ(inplace_string_integer_hash()(strings[i]), hashes[i]);
+}
+
+TEST(inplace_string_algorithm, hash_batch)
+{
+	test_hash_batch<3>();
+	test_hash_batch<7>();
+	test_hash_batch<15>();
+}
+
+TEST(inplace_string_algorithm, equal_batch)
+{
+	const std::vector<inplace_string<15>> lhs = {"foo", "bar", "", "foobar", "fo"};
+	const std::vector<inplace_string<15>> rhs = {"foo", "baz", "", "foo", "foo"};
+
+	std::vector<std::uint8_t> result(lhs.size());
+	equal_batch(lhs.data(), lhs.data() + lhs.size(), rhs.data(), result.data());
+	EXPECT_EQ((std::vector<std::uint8_t>{1, 0, 1, 0, 0}), result);
+}
+
+TEST(front_coded_set, lookup)
+{
+	std::vector<inplace_string<23>> strings;
+	for (int strike = 4000; strike < 6000; strike += 5)
+	{
+		strings.emplace_back("SPXW 261016C" + std::to_string(strike));
+		strings.emplace_back("SPXW 261016P" + std::to_string(strike));
+	}
+	std::sort(strings.begin(), strings.end());
+
+	const front_coded_set<23> set(strings.begin(), strings.end());
+	EXPECT_EQ(strings.size(), set.size());
+	EXPECT_EQ(50, set.block_count());
+	EXPECT_LT(4 * set.memory_usage(), strings.size() * sizeof(inplace_string<23>));
+
+	EXPECT_TRUE(std::equal(set.begin(), set.end(), strings.begin(), strings.end()));
+
+	for (std::size_t i = 0; i < strings.size(); i += 7)
+	{
+		EXPECT_EQ(strings[i], set[i]);
+		EXPECT_EQ(i, set.find(strings[i]));
+	}
+
+	EXPECT_EQ(0, set.lower_bound("A"));
+	EXPECT_EQ(0, set.lower_bound("SPXW 261016C4000"));
+	EXPECT_EQ(1, set.lower_bound("SPXW 261016C40000"));
+	EXPECT_EQ(strings.size(), set.lower_bound("SPXW 261016P6000"));
+	EXPECT_EQ(set.npos, set.find("SPXW 261016P4001"));
+	EXPECT_FALSE(set.contains("SPXW 261016P40050000000000"));
+	EXPECT_THROW(set.at(strings.size()), std::out_of_range);
+
+	inplace_string<23> block[16];
+	EXPECT_EQ(16, set.decode_block(1, block));
+	EXPECT_TRUE(std::equal(block, block + 16, strings.begin() + 16));
+}
+
+TEST(front_coded_set, construct)
+{
+	const std::vector<std::string> strings = {"", "a", "a", "ab", "abc", "b"};
+	const front_coded_set<3, 2> set(strings.begin(), strings.end());
+	EXPECT_EQ(5, set.size());
+	EXPECT_EQ(3, set.block_count());
+	EXPECT_EQ("", set[0]);
+	EXPECT_EQ("abc", set[3]);
+	EXPECT_EQ(1, set.find("a"));
+	EXPECT_EQ(4, set.find("b"));
+
+	inplace_string<3> block[2];
+	EXPECT_EQ(1, set.decode_block(2, block));
+	EXPECT_EQ("b", block[0]);
+
+	const std::vector<std::string> unsorted = {"b", "a"};
+	EXPECT_THROW((front_coded_set<3>(unsorted.begin(), unsorted.end())), std::invalid_argument);
+
+	const front_coded_set<3> empty;
+	EXPECT_EQ(0, empty.lower_bound("a"));
+	EXPECT_FALSE(empty.contains(""));
+	EXPECT_TRUE(empty.begin() == empty.end());
+}
+
+TEST(dictionary_column, encode)
+{
+	dictionary_column<7, std::uint8_t> column{"foo", "bar", "foo", "", "bar"};
+	EXPECT_EQ(5, column.size());
+	EXPECT_EQ(3, column.dictionary().size());
+	EXPECT_EQ((std::vector<std::uint8_t>{0, 1, 0, 2, 1}), column.codes());
+	EXPECT_EQ("bar", column[4]);
+	EXPECT_THROW(column.at(5), std::out_of_range);
+
+	std::uint8_t code;
+	EXPECT_TRUE(column.find_code("", code));
+	EXPECT_EQ(2, code);
+	EXPECT_FALSE(column.find_code("baz", code));
+	EXPECT_FALSE(column.find_code("foobarbaz", code));
+
+	for (int i = 0; i < 253; ++i)
+		column.push_back(std::to_string(i));
+	EXPECT_EQ(256, column.dictionary().size());
+	EXPECT_EQ(0, column.push_back("foo"));
+	EXPECT_THROW(column.push_back("256"), std::length_error);
+}
+
+TEST(dictionary_column, select)
+{
+	const std::vector<std::string> values = {"AAPL", "MSFT", "AMZN", "GOOG", "AMD"};
+
+	dictionary_column<7, std::uint16_t> column;
+	std::vector<std::string> rows;
+	for (std::size_t i = 0; i < 1000; ++i)
+	{
+		rows.push_back(values[(i * i) % values.size()]);
+		column.push_back(rows.back());
+	}
+
+	std::vector<std::uint64_t> bitmap(column.bitmap_size(column.size()), ~std::uint64_t{0});
+	auto check = [&](auto pred)
+	{
+		for (std::size_t i = 0; i < bitmap.size() * 64; ++i)
+		{
+			const bool expected = i < rows.size() && pred(rows[i]);
+			EXPECT_EQ(expected, (bitmap[i / 64] >> (i % 64)) & 1) << i;
+		}
+	};
+
+	column.select_equal("MSFT", bitmap.data());
+	check([](const std::string& s) { return s == "MSFT"; });
+
+	column.select_equal("IBM", bitmap.data());
+	check([](const std::string&) { return false; });
+
+	column.select_starts_with("AM", bitmap.data());
+	check([](const std::string& s) { return s.compare(0, 2, "AM") == 0; });
+
+	column.select_contains("O", bitmap.data());
+	check([](const std::string& s) { return s.find('O') != std::string::npos; });
+
+	column.select_range("AMZN", "MSFT", bitmap.data());
+	check([](const std::string& s) { return s >= "AMZN" && s < "MSFT"; });
+
+	column.select([](const inplace_string<7>& s) { return s.size() == 3; }, bitmap.data());
+	check([](const std::string& s) { return s.size() == 3; });
+}
+
+TEST(inplace_string_file, map)
+{
+	std::vector<inplace_string<15>> strings;
+	for (int i = 0; i < 1000; ++i)
+		strings.emplace_back("SYM" + std::to_string(i * 31));
+
+	const std::string tmp = std::tmpnam(nullptr);
+
+	for (bool with_index : {false, true})
+	{
+		write_inplace_string_file(tmp, strings.data(), strings.data() + strings.size(), with_index);
+
+		const mapped_inplace_string_file<15> file(tmp);
+		EXPECT_EQ(with_index, file.has_index());
+		ASSERT_EQ(strings.size(), file.size());
+		EXPECT_TRUE(std::equal(file.begin(), file.end(), strings.begin(), strings.end()));
+		EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(file.data()) % alignof(inplace_string<15>));
+
+		for (std::size_t i = 0; i < strings.size(); i += 13)
+			EXPECT_EQ(i, file.find(strings[i]));
+		EXPECT_EQ(file.size(), file.find("SYM1"));
+	}
+
+	// another capacity or character type
+	EXPECT_THROW((mapped_inplace_string_file<7>(tmp)), std::runtime_error);
+	EXPECT_THROW((mapped_inplace_string_file<7, char16_t>(tmp)), std::runtime_error);
+
+	std::remove(tmp.c_str());
+	EXPECT_THROW((mapped_inplace_string_file<15>(tmp)), std::runtime_error);
+}
+
+TEST(inplace_string_file, long_strings)
+{
+	const std::vector<inplace_string<47>> strings = {"", "a", "the quick brown fox jumps over the lazy dog"};
+	const std::string tmp = std::tmpnam(nullptr);
+	write_inplace_string_file(tmp, strings.data(), strings.data() + strings.size(), true);
+
+	const mapped_inplace_string_file<47> file(tmp);
+	for (std::size_t i = 0; i < strings.size(); ++i)
+		EXPECT_EQ(i, file.find(strings[i]));
+	EXPECT_EQ(3, file.find("b"));
+
+	std::remove(tmp.c_str());
+
+	write_inplace_string_file(tmp, strings.data(), strings.data(), true);
+	const mapped_inplace_string_file<47> empty(tmp);
+	EXPECT_TRUE(empty.empty());
+	EXPECT_EQ(0, empty.find("a"));
+	std::remove(tmp.c_str());
+}
+
+TEST(inplace_string_file, map_file)
+{
+	struct instrument
+	{
+		std::uint32_t id;
+		double tick_size;
+	};
+
+	std::vector<inplace_string<15>> keys;
+	std::vector<instrument> values;
+	for (std::uint32_t i = 0; i < 2000; ++i)
+	{
+		keys.emplace_back("INSTR" + std::to_string(i));
+		values.push_back(instrument{i, 0.01 * i});
+	}
+	keys.emplace_back("INSTR7");
+	values.push_back(instrument{0, 0.0});
+
+	const std::string tmp = std::tmpnam(nullptr);
+	write_inplace_string_map_file(tmp, keys.data(), keys.data() + keys.size(), values.data());
+
+	const mapped_inplace_string_map<15, instrument> map(tmp);
+	EXPECT_EQ(keys.size(), map.size());
+
+	for (std::uint32_t i = 0; i < 2000; ++i)
+	{
+		const instrument* value = map.find(keys[i]);
+		ASSERT_NE(nullptr, value);
+		EXPECT_EQ(i, value->id);
+	}
+
+	EXPECT_EQ(7, map.at("INSTR7").id);
+	EXPECT_EQ(nullptr, map.find("INSTR2000"));
+	EXPECT_FALSE(map.contains(""));
+	EXPECT_THROW(map.at("FOO"), std::out_of_range);
+
+	// neither a string table, nor a map of another value type
+	EXPECT_THROW((mapped_inplace_string_file<15>(tmp)), std::runtime_error);
+	EXPECT_THROW((mapped_inplace_string_map<15, std::uint32_t>(tmp)), std::runtime_error);
+
+	std::remove(tmp.c_str());
+}
+
+TEST(inplace_string_match, match)
+{
+	EXPECT_EQ(0, match(inplace_string<31>("NewOrderSingle"), "NewOrderSingle", "OrderCancelRequest"));
+	EXPECT_EQ(1, match(inplace_string<31>("OrderCancelRequest"), "NewOrderSingle", "OrderCancelRequest"));
+	EXPECT_EQ(2, match(inplace_string<31>("NewOrderSingl"), "NewOrderSingle", "OrderCancelRequest"));
+	EXPECT_EQ(1, match(inplace_string<3>(""), "a", "", "b"));
+	EXPECT_EQ(0, match(basic_string_view<char, std::char_traits<char>>("b"), "b"));
+}
+
+TEST(inplace_string_match, string_matcher)
+{
+	static constexpr auto messages = make_string_matcher(
+		"NewOrderSingle", "NewOrderCross", "NewOrderList", "OrderCancelRequest", "OrderCancelReplaceRequest",
+		"ExecutionReport", "OrderCancelReject", "Heartbeat", "Logon", "Logout", "", "A", "0", "8", "D", "F", "G",
+		"NewOrderSingleX", "XNewOrderSingle");
+
+	static_assert(messages.size() == 19, "");
+	static_assert(messages.index_of("NewOrderCross") == 1, "");
+	static_assert(messages.index_of("Foo") == messages.npos, "");
+
+	const char* keys[] = {
+		"NewOrderSingle", "NewOrderCross", "NewOrderList", "OrderCancelRequest", "OrderCancelReplaceRequest",
+		"ExecutionReport", "OrderCancelReject", "Heartbeat", "Logon", "Logout", "", "A", "0", "8", "D", "F", "G",
+		"NewOrderSingleX", "XNewOrderSingle"};
+
+	for (std::size_t i = 0; i < messages.size(); ++i)
+	{
+		EXPECT_EQ(i, messages(inplace_string<31>(keys[i])));
+		EXPECT_EQ(i, messages(basic_string_view<char, std::char_traits<char>>(keys[i])));
+	}
+
+	for (const char* other : {"NewOrderSingl", "ewOrderSingle", "B", "Logo", "LogonLogonLogonLogonLogonLogonLogon", "Heartbeats"})
+		EXPECT_EQ(messages.npos, messages(basic_string_view<char, std::char_traits<char>>(other))) << other;
+
+	switch (messages(inplace_string<31>("Logon")))
+	{
+	case messages.index_of("Logon"):
+		break;
+	default:
+		ADD_FAILURE();
+	}
+}
+
+TEST(inplace_string_match, string_matcher_large)
+{
+	// FIX field names: one seed per bucket of about 4 keys, whatever the number of keys
+	static constexpr auto fields = make_string_matcher(
+		"Account", "AdvId", "AdvRefID", "AdvSide", "AdvTransType", "AvgPx", "BeginSeqNo", "BeginString",
+		"BodyLength", "CheckSum", "ClOrdID", "Commission", "CommType", "CumQty", "Currency", "EndSeqNo",
+		"ExecID", "ExecInst", "ExecRefID", "ExecTransType", "HandlInst", "SecurityIDSource", "IOIID", "IOIQltyInd",
+		"IOIRefID", "IOIQty", "IOITransType", "LastCapacity", "LastMkt", "LastPx", "LastQty", "NoLinesOfText",
+		"MsgSeqNum", "MsgType", "NewSeqNo", "OrderID", "OrderQty", "OrdStatus", "OrdType", "OrigClOrdID",
+		"OrigTime", "PossDupFlag", "Price", "RefSeqNum", "SecurityID", "SenderCompID", "SenderSubID", "SendingTime",
+		"Quantity", "Side", "Symbol", "TargetCompID", "TargetSubID", "Text", "TimeInForce", "TransactTime",
+		"Urgency", "ValidUntilTime", "SettlType", "SettlDate", "SymbolSfx", "ListID", "ListSeqNo", "TotNoOrders",
+		"ListExecInst", "AllocID", "AllocTransType", "RefAllocID", "NoOrders", "AvgPxPrecision", "TradeDate", "PositionEffect",
+		"NoAllocs", "AllocAccount", "AllocQty", "ProcessCode", "NoRpts", "RptSeq", "CxlQty", "NoDlvyInst",
+		"AllocStatus", "AllocRejCode", "Signature", "SecureDataLen", "SecureData", "SignatureLength", "EmailType", "RawDataLength",
+		"RawData", "PossResend", "EncryptMethod", "StopPx", "ExDestination", "CxlRejReason", "OrdRejReason", "IOIQualifier",
+		"WaveNo", "Issuer", "SecurityDesc", "HeartBtInt", "MinQty", "MaxFloor", "TestReqID", "ReportToExch",
+		"LocateReqd", "OnBehalfOfCompID");
+	static_assert(fields.size() == 106, "");
+	static_assert(fields.index_of("Symbol") == 50, "");
+
+	const char* names[] = {
+		"Account", "AdvId", "AdvRefID", "AdvSide", "AdvTransType", "AvgPx", "BeginSeqNo", "BeginString",
+		"BodyLength", "CheckSum", "ClOrdID", "Commission", "CommType", "CumQty", "Currency", "EndSeqNo",
+		"ExecID", "ExecInst", "ExecRefID", "ExecTransType", "HandlInst", "SecurityIDSource", "IOIID", "IOIQltyInd",
+		"IOIRefID", "IOIQty", "IOITransType", "LastCapacity", "LastMkt", "LastPx", "LastQty", "NoLinesOfText",
+		"MsgSeqNum", "MsgType", "NewSeqNo", "OrderID", "OrderQty", "OrdStatus", "OrdType", "OrigClOrdID",
+		"OrigTime", "PossDupFlag", "Price", "RefSeqNum", "SecurityID", "SenderCompID", "SenderSubID", "SendingTime",
+		"Quantity", "Side", "Symbol", "TargetCompID", "TargetSubID", "Text", "TimeInForce", "TransactTime",
+		"Urgency", "ValidUntilTime", "SettlType", "SettlDate", "SymbolSfx", "ListID", "ListSeqNo", "TotNoOrders",
+		"ListExecInst", "AllocID", "AllocTransType", "RefAllocID", "NoOrders", "AvgPxPrecision", "TradeDate", "PositionEffect",
+		"NoAllocs", "AllocAccount", "AllocQty", "ProcessCode", "NoRpts", "RptSeq", "CxlQty", "NoDlvyInst",
+		"AllocStatus", "AllocRejCode", "Signature", "SecureDataLen", "SecureData", "SignatureLength", "EmailType", "RawDataLength",
+		"RawData", "PossResend", "EncryptMethod", "StopPx", "ExDestination", "CxlRejReason", "OrdRejReason", "IOIQualifier",
+		"WaveNo", "Issuer", "SecurityDesc", "HeartBtInt", "MinQty", "MaxFloor", "TestReqID", "ReportToExch",
+		"LocateReqd", "OnBehalfOfCompID"};
+	for (std::size_t i = 0; i < fields.size(); ++i)
+		EXPECT_EQ(i, fields(inplace_string<31>(names[i]))) << names[i];
+	for (const char* other : {"", "Symbo", "symbol", "OrderQty2", "ClOrdId", "OnBehalfOfCompIDX", "MsgTyp"})
+		EXPECT_EQ(fields.npos, fields(basic_string_view<char, std::char_traits<char>>(other))) << other;
+
+	// built at run time as well
+	const auto runtime = make_string_matcher(
+		"Account", "AdvId", "AdvRefID", "AdvSide", "AdvTransType", "AvgPx", "BeginSeqNo", "BeginString",
+		"BodyLength", "CheckSum", "ClOrdID", "Commission", "CommType", "CumQty", "Currency", "EndSeqNo",
+		"ExecID", "ExecInst", "ExecRefID", "ExecTransType", "HandlInst", "SecurityIDSource", "IOIID", "IOIQltyInd",
+		"IOIRefID", "IOIQty", "IOITransType", "LastCapacity", "LastMkt", "LastPx", "LastQty", "NoLinesOfText",
+		"MsgSeqNum", "MsgType", "NewSeqNo", "OrderID", "OrderQty", "OrdStatus", "OrdType", "OrigClOrdID",
+		"OrigTime", "PossDupFlag", "Price", "RefSeqNum", "SecurityID", "SenderCompID", "SenderSubID", "SendingTime",
+		"Quantity", "Side", "Symbol", "TargetCompID", "TargetSubID", "Text", "TimeInForce", "TransactTime",
+		"Urgency", "ValidUntilTime", "SettlType", "SettlDate", "SymbolSfx", "ListID", "ListSeqNo", "TotNoOrders",
+		"ListExecInst", "AllocID", "AllocTransType", "RefAllocID", "NoOrders", "AvgPxPrecision", "TradeDate", "PositionEffect",
+		"NoAllocs", "AllocAccount", "AllocQty", "ProcessCode", "NoRpts", "RptSeq", "CxlQty", "NoDlvyInst",
+		"AllocStatus", "AllocRejCode", "Signature", "SecureDataLen", "SecureData", "SignatureLength", "EmailType", "RawDataLength",
+		"RawData", "PossResend", "EncryptMethod", "StopPx", "ExDestination", "CxlRejReason", "OrdRejReason", "IOIQualifier",
+		"WaveNo", "Issuer", "SecurityDesc", "HeartBtInt", "MinQty", "MaxFloor", "TestReqID", "ReportToExch",
+		"LocateReqd", "OnBehalfOfCompID");
+	for (std::size_t i = 0; i < runtime.size(); ++i)
+		EXPECT_EQ(i, runtime(inplace_string<31>(names[i]))) << names[i];
+}
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+template <fixed_string Name, std::size_t N>
+struct test_field
+{
+	static constexpr auto name = Name;
+	inplace_string<N> value;
+};
+#endif
+
+TEST(fixed_string, construct)
+{
+	constexpr fixed_string symbol("Symbol");
+	static_assert(symbol.size() == 6, "");
+	static_assert(symbol[5] == 'l', "");
+	static_assert(symbol == fixed_string("Symbol"), "");
+	static_assert(symbol != fixed_string("Symbo"), "");
+	static_assert(symbol != fixed_string("Symbox"), "");
+	static_assert(basic_string_view<char, std::char_traits<char>>(symbol) == "Symbol", "");
+
+	const inplace_string<15> s = symbol;
+	EXPECT_EQ("Symbol", s);
+	EXPECT_TRUE(s == symbol);
+	EXPECT_TRUE(symbol == s);
+	EXPECT_FALSE(inplace_string<15>("Symbo") == symbol);
+	EXPECT_TRUE(inplace_string<3>("Sym") != symbol);
+	EXPECT_TRUE(inplace_string<3>("") == fixed_string(""));
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+	using symbol_field = test_field<"Symbol"_fs, 15>;
+	static_assert(std::is_same<test_field<fixed_string("Symbol"), 15>, symbol_field>::value, "");
+	static_assert(!std::is_same<test_field<"Side"_fs, 15>, symbol_field>::value, "");
+	EXPECT_TRUE(s == symbol_field::name);
+#endif
+}
+
+template <std::size_t N>
+static void test_atomic_inplace_string()
+{
+	atomic_inplace_string<N> str;
+	EXPECT_EQ("", str.load());
+
+	str.store("foo");
+	EXPECT_EQ("foo", str.load());
+
+	str = "bar";
+	EXPECT_EQ("bar", static_cast<inplace_string<N>>(str));
+	EXPECT_EQ("bar", str.exchange("baz"));
+
+	inplace_string<N> expected = "foo";
+	EXPECT_FALSE(str.compare_exchange(expected, "qux"));
+	EXPECT_EQ("baz", expected);
+	EXPECT_TRUE(str.compare_exchange(expected, "qux"));
+	EXPECT_EQ("qux", str.load());
+
+	// the writer publishes strings made of a single repeated character, their size depending on that character: a torn
+	// read would mix two of them
+	str.store("a");
+	std::atomic<bool> done{false};
+	std::thread writer([&]()
+	{
+		for (std::size_t i = 0; i < 20000; ++i)
+		{
+			const char c = static_cast<char>('a' + i % 26);
+			str.store(inplace_string<N>(1 + static_cast<std::size_t>(c - 'a') % N, c));
+		}
+		done = true;
+	});
+
+	std::size_t torn = 0;
+	while (!done)
+	{
+		const inplace_string<N> s = str.load();
+		torn += s.size() != 1 + static_cast<std::size_t>(s[0] - 'a') % N || std::count(s.begin(), s.end(), s[0]) != static_cast<std::ptrdiff_t>(s.size());
+	}
+	writer.join();
+	EXPECT_EQ(0, torn);
+}
+
+TEST(atomic_inplace_string, operations)
+{
+	static_assert(atomic_inplace_string<7>::is_always_lock_free, "");
+	static_assert(!atomic_inplace_string<15>::is_always_lock_free, "");
+
+	test_atomic_inplace_string<7>();
+	test_atomic_inplace_string<15>();
+	test_atomic_inplace_string<47>();
+}
+
+TEST(concurrent_inplace_string_map, operations)
+{
+	concurrent_inplace_string_map<15, int> map(4);
+	EXPECT_EQ(4, map.capacity());
+	EXPECT_TRUE(map.empty());
+
+	EXPECT_TRUE(map.insert("AAPL", 1));
+	EXPECT_TRUE(map.insert("MSFT", 2));
+	EXPECT_FALSE(map.insert("AAPL", 3));
+	EXPECT_EQ(2, map.size());
+
+	int value = 0;
+	EXPECT_TRUE(map.find("AAPL", value));
+	EXPECT_EQ(1, value);
+	EXPECT_TRUE(map.find(std::string("MSFT"), value));
+	EXPECT_EQ(2, value);
+	EXPECT_FALSE(map.find("GOOG", value));
+	EXPECT_FALSE(map.contains("a string longer than the capacity"));
+
+	map.insert_or_assign("AAPL", 3);
+	EXPECT_TRUE(map.find("AAPL", value));
+	EXPECT_EQ(3, value);
+
+	EXPECT_TRUE(map.erase("AAPL"));
+	EXPECT_FALSE(map.erase("AAPL"));
+	EXPECT_FALSE(map.contains("AAPL"));
+	EXPECT_TRUE(map.contains("MSFT"));
+	EXPECT_EQ(1, map.size());
+
+	// the erased slot is reused
+	EXPECT_TRUE(map.insert("AAPL", 4));
+	EXPECT_TRUE(map.insert("IBM", 5));
+	EXPECT_TRUE(map.insert("ORCL", 6));
+	EXPECT_THROW(map.insert("GOOG", 7), std::length_error);
+	EXPECT_EQ(4, map.size());
+	EXPECT_TRUE(map.find("ORCL", value));
+	EXPECT_EQ(6, value);
+}
+
+TEST(concurrent_inplace_string_map, concurrent_readers)
+{
+	struct quote
+	{
+		std::uint64_t bid;
+		std::uint64_t ask;
+	};
+
+	// the writer always publishes ask == bid + 1: a torn read would break it
+	concurrent_inplace_string_map<31, quote> map(64);
+	std::vector<inplace_string<31>> keys;
+	for (int i = 0; i < 32; ++i)
+		keys.emplace_back("instrument " + std::to_string(i));
+
+	std::atomic<bool> done{false};
+	std::thread writer([&]()
+	{
+		for (std::uint64_t i = 0; i < 20000; ++i)
+		{
+			const inplace_string<31>& key = keys[i % keys.size()];
+			if (i % 7 == 0)
+				map.erase(key);
+			else
+				map.insert_or_assign(key, quote{i, i + 1});
+		}
+		done = true;
+	});
+
+	std::size_t torn = 0;
+	while (!done)
+	{
+		for (const inplace_string<31>& key : keys)
+		{
+			quote q;
+			if (map.find(key, q))
+				torn += q.ask != q.bid + 1;
+		}
+	}
+	writer.join();
+	EXPECT_EQ(0, torn);
+	EXPECT_LE(map.size(), keys.size());
+}
+
+struct ring_quote
+{
+	inplace_string<15> symbol;
+	std::uint64_t sequence;
+	std::uint64_t price;
+};
+
+template <typename Ring>
+static std::vector<unsigned char> test_ring_memory(std::size_t capacity)
+{
+	// over-allocated to align on 64 bytes
+	return std::vector<unsigned char>(Ring::memory_size(capacity) + 64);
+}
+
+static void* test_ring_align(std::vector<unsigned char>& memory)
+{
+	const std::uintptr_t p = reinterpret_cast<std::uintptr_t>(memory.data());
+	return memory.data() + (64 - p % 64) % 64;
+}
+
+TEST(inplace_string_ring, spsc)
+{
+	static_assert(sizeof(detail::ring_slot<ring_quote, false>) == 64, "");
+
+	std::vector<unsigned char> memory = test_ring_memory<spsc_ring<ring_quote>>(8);
+	void* p = test_ring_align(memory);
+
+	EXPECT_THROW(spsc_ring<ring_quote>::create(p, 6), std::invalid_argument);
+	spsc_ring<ring_quote> ring = spsc_ring<ring_quote>::create(p, 8);
+	EXPECT_EQ(8, ring.capacity());
+	EXPECT_EQ(0, ring.size());
+
+	ring_quote q;
+	EXPECT_FALSE(ring.try_pop(q));
+	EXPECT_TRUE(ring.try_push(ring_quote{"AAPL", 1, 100}));
+
+	// batches wrap around the end of the ring
+	for (std::uint64_t i = 2; i <= 6; ++i)
+		EXPECT_TRUE(ring.try_push(ring_quote{"MSFT", i, 200}));
+
+	spsc_ring<ring_quote>::batch b = ring.peek(4);
+	ASSERT_EQ(4, b.size());
+	EXPECT_EQ("AAPL", b[0].symbol);
+	EXPECT_EQ(4, b[3].sequence);
+	ring.consume(b.size());
+
+	b = ring.claim(10);
+	ASSERT_EQ(6, b.size());
+	for (std::size_t i = 0; i < b.size(); ++i)
+		b[i] = ring_quote{"IBM", 7 + i, 300};
+	ring.publish(b);
+	EXPECT_EQ(0, ring.claim(1).size());
+	EXPECT_FALSE(ring.try_push(q));
+	EXPECT_EQ(8, ring.size());
+
+	// attached by another process, e.g. through shared_memory
+	const std::size_t size = spsc_ring<ring_quote>::memory_size(8);
+	spsc_ring<ring_quote> consumer = spsc_ring<ring_quote>::attach(p, size);
+	for (std::uint64_t i = 5; i <= 12; ++i)
+	{
+		ASSERT_TRUE(consumer.try_pop(q));
+		EXPECT_EQ(i, q.sequence);
+	}
+	EXPECT_FALSE(consumer.try_pop(q));
+	EXPECT_THROW(mpsc_ring<ring_quote>::attach(p, size), std::runtime_error);
+
+	// memory smaller than the ring, corrupted capacity
+	EXPECT_THROW(spsc_ring<ring_quote>::attach(p, size - 1), std::runtime_error);
+	EXPECT_THROW(spsc_ring<ring_quote>::attach(p, 16), std::runtime_error);
+	detail::ring_header* header = static_cast<detail::ring_header*>(p);
+	for (std::uint64_t capacity : {std::uint64_t{0}, std::uint64_t{6}, std::uint64_t{16}})
+	{
+		header->capacity = capacity;
+		EXPECT_THROW(spsc_ring<ring_quote>::attach(p, size), std::runtime_error);
+	}
+	header->capacity = 8;
+	EXPECT_NO_THROW(spsc_ring<ring_quote>::attach(p, size));
+}
+
+TEST(inplace_string_ring, threads)
+{
+	// the threads yield when the ring is full or empty, the tests running on single-core machines as well
+	const std::uint64_t count = 20000;
+
+	std::vector<unsigned char> spsc_memory = test_ring_memory<spsc_ring<ring_quote>>(64);
+	spsc_ring<ring_quote> spsc = spsc_ring<ring_quote>::create(test_ring_align(spsc_memory), 64);
+
+	std::thread producer([&]()
+	{
+		for (std::uint64_t i = 0; i < count;)
+		{
+			const spsc_ring<ring_quote>::batch b = spsc.claim(16);
+			for (std::size_t j = 0; j < b.size() && i < count; ++j, ++i)
+				b[j] = ring_quote{"AAPL", i, 2 * i};
+			spsc.publish(b);
+			if (b.empty())
+				std::this_thread::yield();
+		}
+	});
+
+	std::uint64_t expected = 0, errors = 0;
+	while (expected < count)
+	{
+		const spsc_ring<ring_quote>::batch b = spsc.peek(16);
+		for (std::size_t j = 0; j < b.size(); ++j, ++expected)
+			errors += b[j].sequence != expected || b[j].price != 2 * expected || b[j].symbol != "AAPL";
+		spsc.consume(b.size());
+		if (b.empty())
+			std::this_thread::yield();
+	}
+	producer.join();
+	EXPECT_EQ(0, errors);
+
+	std::vector<unsigned char> mpsc_memory = test_ring_memory<mpsc_ring<ring_quote>>(64);
+	mpsc_ring<ring_quote> mpsc = mpsc_ring<ring_quote>::create(test_ring_align(mpsc_memory), 64);
+
+	// each producer publishes increasing sequences under its own symbol
+	std::vector<std::thread> producers;
+	for (int k = 0; k < 3; ++k)
+	{
+		producers.emplace_back([&mpsc, k, count]()
+		{
+			const inplace_string<15> symbol(1, static_cast<char>('A' + k));
+			for (std::uint64_t i = 0; i < count / 4;)
+			{
+				const mpsc_ring<ring_quote>::batch b = mpsc.claim(4);
+				for (std::size_t j = 0; j < b.size(); ++j, ++i)
+					b[j] = ring_quote{symbol, i, 0};
+				mpsc.publish(b);
+				if (b.empty())
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	std::uint64_t next[3] = {0, 0, 0};
+	std::uint64_t received = 0;
+	errors = 0;
+	while (received < 3 * (count / 4))
+	{
+		ring_quote q;
+		if (!mpsc.try_pop(q))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		const std::size_t k = static_cast<std::size_t>(q.symbol[0] - 'A');
+		errors += k >= 3 || q.sequence != next[k]++;
+		++received;
+	}
+	for (std::thread& t : producers)
+		t.join();
+	EXPECT_EQ(0, errors);
+	EXPECT_EQ(0, mpsc.size());
+}
+
+TEST(inplace_string_ring, copy_live_prefix)
+{
+	inplace_string<127> dst(100, 'x');
+	const inplace_string<127> src("short");
+	copy_live_prefix(dst, src);
+	EXPECT_EQ(src, dst);
+	EXPECT_EQ(0, std::memcmp(&dst, &src, sizeof(dst)));
+
+	const inplace_string<127> longer(120, 'y');
+	copy_live_prefix(dst, longer);
+	EXPECT_EQ(0, std::memcmp(&dst, &longer, sizeof(dst)));
+
+	inplace_string<15> small;
+	copy_live_prefix(small, inplace_string<15>("AAPL"));
+	EXPECT_EQ("AAPL", small);
+}
+
+TEST(inplace_string_ring, shared_memory)
+{
+	const std::string name = "/inplace_string_ring_test";
+	shared_memory::remove(name);
+
+	shared_memory producer_shm = shared_memory::create(name, spsc_ring<ring_quote>::memory_size(16));
+	EXPECT_THROW(shared_memory::create(name, 4096), std::runtime_error);
+	spsc_ring<ring_quote> producer = spsc_ring<ring_quote>::create(producer_shm.data(), 16);
+
+	// a second mapping of the same segment, as in another process
+	shared_memory consumer_shm = shared_memory::open(name);
+	EXPECT_LE(spsc_ring<ring_quote>::memory_size(16), consumer_shm.size());
+	EXPECT_NE(producer_shm.data(), consumer_shm.data());
+	spsc_ring<ring_quote> consumer = spsc_ring<ring_quote>::attach(consumer_shm.data(), consumer_shm.size());
+
+	EXPECT_TRUE(producer.try_push(ring_quote{"AAPL", 1, 100}));
+	ring_quote q;
+	ASSERT_TRUE(consumer.try_pop(q));
+	EXPECT_EQ("AAPL", q.symbol);
+	EXPECT_EQ(100, q.price);
+
+	shared_memory::remove(name);
+	EXPECT_THROW(shared_memory::open(name), std::runtime_error);
+}
+
+TEST(inplace_string, stream_extraction)
+{
+	std::istringstream is("  AAPL MSFT\tVERYLONGWORD\nIBM");
+	inplace_string<7> s;
+
+	EXPECT_TRUE(is >> s);
+	EXPECT_EQ("AAPL", s);
+	EXPECT_TRUE(is >> s);
+	EXPECT_EQ("MSFT", s);
+
+	// cut to the capacity, the rest of the word left in the stream
+	EXPECT_FALSE(is >> s);
+	EXPECT_EQ("VERYLON", s);
+	is.clear();
+	EXPECT_TRUE(is >> s);
+	EXPECT_EQ("GWORD", s);
+
+	is >> std::setw(3) >> s;
+	EXPECT_TRUE(is);
+	EXPECT_EQ("IBM", s);
+	EXPECT_TRUE(is.eof());
+	EXPECT_FALSE(is >> s);
+
+	std::istringstream lines("first line\n\na line too long\nlast");
+	inplace_string<10> line;
+	EXPECT_TRUE(getline(lines, line));
+	EXPECT_EQ("first line", line);
+	EXPECT_TRUE(getline(lines, line));
+	EXPECT_EQ("", line);
+	EXPECT_FALSE(getline(lines, line));
+	EXPECT_EQ("a line too", line);
+	lines.clear();
+	EXPECT_TRUE(getline(lines, line));
+	EXPECT_EQ(" long", line);
+	EXPECT_TRUE(getline(lines, line, 't'));
+	EXPECT_EQ("las", line);
+	EXPECT_FALSE(getline(lines, line));
+
+	std::wistringstream wis(L"wide string");
+	inplace_wstring<7> ws;
+	EXPECT_TRUE(wis >> ws);
+	EXPECT_EQ(L"wide", ws);
+}
+
+TEST(inplace_string_reader, lines)
+{
+	std::string content;
+	std::vector<std::string> expected;
+	for (int i = 0; i < 1000; ++i)
+	{
+		expected.push_back(std::string(static_cast<std::size_t>(i % 40), static_cast<char>('a' + i % 26)));
+		content += expected.back() + "\n";
+	}
+	// a line longer than the buffer, then a last line without '\n'
+	expected.push_back(std::string(100, 'z'));
+	content += std::string(100, 'z') + "\nend";
+	expected.push_back("end");
+
+	const std::string tmp = std::tmpnam(nullptr);
+	std::ofstream(tmp, std::ios::binary) << content;
+
+	std::FILE* file = std::fopen(tmp.c_str(), "rb");
+	ASSERT_NE(nullptr, file);
+#if defined(_WIN32)
+	line_reader<31> reader(_fileno(file), 64);
+#else
+	line_reader<31> reader(fileno(file), 64);
+#endif
+
+	std::size_t i = 0;
+	inplace_string<31> line;
+	while (reader.next(line))
+	{
+		ASSERT_LT(i, expected.size());
+		EXPECT_EQ(expected[i].substr(0, 31), std::string(line.c_str())) << i;
+		++i;
+	}
+	EXPECT_EQ(expected.size(), i);
+	EXPECT_EQ(expected.size(), reader.lines());
+	EXPECT_EQ(1 + 8 * 1000 / 40, reader.truncated());
+	EXPECT_FALSE(reader.next(line));
+
+	std::fclose(file);
+	std::remove(tmp.c_str());
+
+	EXPECT_THROW(line_reader<31>(0, 31), std::invalid_argument);
+}
+
+TEST(inplace_string_csv, parse)
+{
+	const std::string csv =
+		"symbol,exchange,name\r\n"
+		"AAPL,XNAS,Apple Inc.\r\n"
+		"\r\n"
+		"\"BRK,A\",XNYS,\"Berkshire \"\"Class A\"\"\"\n"
+		"MSFT,XNAS\n"
+		"GOOGL,,\"Alphabet\nInc.\"\n"
+		"VERYLONGSYMBOL,XNAS,a name longer than the capacity of the column,extra\n"
+		"IBM,XNYS,\"International\" Business";
+
+	const csv_table<7, 4, 15> table = parse_csv<7, 4, 15>(csv.data(), csv.size());
+	ASSERT_EQ(6, table.rows());
+	EXPECT_EQ((std::vector<std::string>{"symbol", "exchange", "name"}), table.header());
+
+	const inplace_string_vector<7>& symbols = table.column<0>();
+	const inplace_string_vector<4>& exchanges = table.column<1>();
+	const inplace_string_vector<15>& names = table.column<2>();
+
+	EXPECT_EQ("AAPL", symbols[0]);
+	EXPECT_EQ("Apple Inc.", names[0]);
+	EXPECT_EQ("BRK,A", symbols[1]);
+	EXPECT_EQ("XNYS", exchanges[1]);
+	EXPECT_EQ("Berkshire \"Clas", names[1]);
+	EXPECT_EQ("MSFT", symbols[2]);
+	EXPECT_EQ("", names[2]);
+	EXPECT_EQ("", exchanges[3]);
+	EXPECT_EQ("Alphabet\nInc.", names[3]);
+	EXPECT_EQ("VERYLON", symbols[4]);
+	EXPECT_EQ("a name longer t", names[4]);
+	EXPECT_EQ("International B", names[5]);
+
+	EXPECT_EQ((std::vector<csv_overflow>{{1, 2, 19}, {4, 0, 14}, {4, 2, 45}, {5, 2, 22}}), table.overflows());
+
+	csv_options tsv;
+	tsv.delimiter = '\t';
+	tsv.header = false;
+	const std::string tab = "a\tb\nc\td";
+	const csv_table<3, 3> t = parse_csv<3, 3>(tab.data(), tab.size(), tsv);
+	ASSERT_EQ(2, t.rows());
+	EXPECT_TRUE(t.header().empty());
+	EXPECT_EQ("d", t.column<1>()[1]);
+}
+
+TEST(inplace_string_csv, parallel)
+{
+	// quoted fields holding line ends, so that the chunk boundaries fall in them
+	std::string csv = "id,name,comment\n";
+	for (int i = 0; i < 50000; ++i)
+	{
+		csv += std::to_string(i) + ",name " + std::to_string(i);
+		csv += i % 3 == 0 ? ",\"multi\nline, \"\"quoted\"\"\"\n" : ",plain\n";
+	}
+
+	const std::string tmp = std::tmpnam(nullptr);
+	std::ofstream(tmp, std::ios::binary) << csv;
+
+	csv_options options;
+	const csv_table<7, 10, 15> sequential = read_csv<7, 10, 15>(tmp, options);
+	options.threads = 4;
+	const csv_table<7, 10, 15> parallel = read_csv<7, 10, 15>(tmp, options);
+	std::remove(tmp.c_str());
+
+	ASSERT_EQ(50000, sequential.rows());
+	ASSERT_EQ(50000, parallel.rows());
+	EXPECT_EQ("multi\nline, \"qu", sequential.column<2>()[3]);
+	EXPECT_EQ(16667, sequential.overflows().size());
+	EXPECT_EQ(sequential.overflows(), parallel.overflows());
+
+	for (std::size_t i = 0; i < 50000; ++i)
+	{
+		ASSERT_EQ(inplace_string<7>(std::to_string(i)), parallel.column<0>()[i]);
+		ASSERT_EQ(sequential.column<1>()[i], parallel.column<1>()[i]);
+		ASSERT_EQ(sequential.column<2>()[i], parallel.column<2>()[i]);
+	}
+}
+
+TEST(inplace_string_csv, empty_file)
+{
+	const std::string tmp = std::tmpnam(nullptr);
+	std::ofstream(tmp, std::ios::binary).close();
+
+	csv_options options;
+	const csv_table<7, 15> table = read_csv<7, 15>(tmp, options);
+	EXPECT_EQ(0, table.rows());
+	EXPECT_TRUE(table.header().empty());
+	EXPECT_TRUE(table.column<0>().empty());
+	EXPECT_TRUE(table.overflows().empty());
+
+	options.header = false;
+	options.threads = 4;
+	EXPECT_EQ(0, (read_csv<7, 15>(tmp, options).rows()));
+
+	// other mapped files still reject empty files
+	EXPECT_THROW(mapped_inplace_string_file<7>{tmp}, std::runtime_error);
+	std::remove(tmp.c_str());
+}
+
+TEST(inplace_string_writer, pieces)
+{
+	const std::string tmp = std::tmpnam(nullptr);
+	std::FILE* file = std::fopen(tmp.c_str(), "wb");
+	ASSERT_NE(nullptr, file);
+
+	// long pieces referenced, short ones coalesced, the array of iovec and the buffer filled several times
+	const inplace_string<255> long_field(200, 'L');
+	std::string expected;
+	{
+#if defined(_WIN32)
+		vectored_writer out(_fileno(file), 1024);
+#else
+		vectored_writer out(fileno(file), 1024);
+#endif
+		for (int i = 0; i < 1000; ++i)
+		{
+			const inplace_string<15> id(std::to_string(i));
+			out << id << ',' << inplace_string<7>("AAPL") << "," << long_field << std::string(i % 3, 'x') << '\n';
+			expected += std::string(id.c_str()) + ",AAPL," + std::string(long_field.c_str()) + std::string(static_cast<std::size_t>(i % 3), 'x') + "\n";
+
+			// the long field is referenced: written before it goes out of scope
+			if (i % 100 == 99)
+			{
+				EXPECT_NE(0, out.pending());
+				out.flush();
+				EXPECT_EQ(0, out.pending());
+			}
+		}
+		out.write("end", 3);
+		expected += "end";
+	}
+	std::fclose(file);
+
+	std::ifstream is(tmp, std::ios::binary);
+	const std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+	is.close();
+	std::remove(tmp.c_str());
+
+	EXPECT_EQ(expected, content);
+	EXPECT_THROW(vectored_writer(1, 16), std::invalid_argument);
+}
+
+TEST(inplace_string_writer, temporaries)
+{
+	const std::string tmp = std::tmpnam(nullptr);
+	std::FILE* file = std::fopen(tmp.c_str(), "wb");
+	ASSERT_NE(nullptr, file);
+
+	// long temporaries are copied, or written at once when longer than the buffer, not referenced past their lifetime
+	std::string expected;
+	{
+#if defined(_WIN32)
+		vectored_writer out(_fileno(file), 1024);
+#else
+		vectored_writer out(fileno(file), 1024);
+#endif
+		for (int i = 0; i < 50; ++i)
+		{
+			const char c = static_cast<char>('a' + i % 26);
+			out << std::string(200, c) << inplace_string<255>(150, c) << std::to_string(i) << '\n';
+			expected += std::string(200, c) + std::string(150, c) + std::to_string(i) + "\n";
+		}
+		out << std::string(3000, 'Z');
+		expected += std::string(3000, 'Z');
+
+		// character arrays stop at their terminator, not at their size
+		char buffer[32];
+		std::memset(buffer, '?', sizeof(buffer));
+		std::snprintf(buffer, sizeof(buffer), "id=%d", 42);
+		out << buffer << "|" << "";
+		expected += "id=42|";
+		const char unterminated[3] = {'a', 'b', 'c'};
+		out << unterminated;
+		expected += "abc";
+	}
+	std::fclose(file);
+
+	std::ifstream is(tmp, std::ios::binary);
+	const std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+	is.close();
+	std::remove(tmp.c_str());
+
+	EXPECT_EQ(expected, content);
+}
+
+static void test_ingest_delimited(bool io_uring)
+{
+	// records straddling the small blocks, some longer than a block, CRLF and empty lines
+	std::string content;
+	for (int i = 0; i < 3000; ++i)
+	{
+		content += std::to_string(i) + ",SYM" + std::to_string(i % 7) + "," + std::string(static_cast<std::size_t>(i % 150), 'x');
+		content += i % 10 == 0 ? "\r\n\n" : "\n";
+	}
+	content += "last,record";
+
+	const std::string tmp = std::tmpnam(nullptr);
+	std::ofstream(tmp, std::ios::binary) << content;
+
+	ingest_options options;
+	options.block_size = 100;
+	options.max_record_size = 256;
+	options.threads = 3;
+	options.in_flight = 4;
+	options.io_uring = io_uring;
+
+	std::size_t next_record = 0, next_block = 0, truncated = 0, errors = 0;
+	const std::size_t records = ingest_file<63>(tmp, options, [&](const record_batch<63>& batch)
+	{
+		errors += batch.index() != next_block++;
+		truncated += batch.truncated();
+
+		for (std::size_t i = 0; i < batch.size(); ++i, ++next_record)
+		{
+			if (next_record == 3000)
+			{
+				errors += batch.field_count(i) != 2 || batch.field(i, 0) != "last" || batch.field(i, 1) != "record";
+				continue;
+			}
+
+			const std::size_t x = std::min<std::size_t>(next_record % 150, 63);
+			errors += batch.field_count(i) != 3 || batch.field(i, 0) != inplace_string<63>(std::to_string(next_record)) ||
+				batch.field(i, 1) != inplace_string<63>("SYM" + std::to_string(next_record % 7)) || batch.field(i, 2) != inplace_string<63>(x, 'x');
+		}
+	});
+	EXPECT_EQ(0, errors);
+	EXPECT_EQ(3001, records);
+	EXPECT_EQ(3001, next_record);
+	EXPECT_EQ((content.size() + 99) / 100, next_block);
+	EXPECT_EQ(3000 / 150 * (150 - 64), truncated);
+
+	// records longer than max_record_size
+	options.max_record_size = 100;
+	EXPECT_THROW(ingest_file<63>(tmp, options, [](const record_batch<63>&) {}), std::runtime_error);
+
+	// exceptions of the consumer stop the pipeline
+	options.max_record_size = 256;
+	EXPECT_THROW(ingest_file<63>(tmp, options, [](const record_batch<63>& batch)
+	{
+		if (batch.index() == 10)
+			throw std::logic_error("consumer");
+	}), std::logic_error);
+
+	std::remove(tmp.c_str());
+}
+
+TEST(inplace_string_ingest, delimited)
+{
+	test_ingest_delimited(true);
+	test_ingest_delimited(false);
+}
+
+TEST(inplace_string_ingest, fixed_size)
+{
+	// 16-byte records: an 8-character symbol padded with spaces, a 6-character price padded with NULs, 2 spare bytes
+	std::string content;
+	for (int i = 0; i < 1000; ++i)
+	{
+		std::string record = "S" + std::to_string(i);
+		record.resize(8, ' ');
+		std::string price = std::to_string(i * 3);
+		price.resize(6, '\0');
+		content += record + price + "--";
+	}
+	content += "incomplete";
+
+	const std::string tmp = std::tmpnam(nullptr);
+	std::ofstream(tmp, std::ios::binary) << content;
+
+	ingest_options options;
+	options.record_size = 16;
+	options.fields = {{0, 8}, {8, 6}};
+	options.block_size = 200; // rounded down to 12 records
+	options.threads = 2;
+
+	std::size_t next = 0, errors = 0;
+	const std::size_t records = ingest_file<7>(tmp, options, [&](const record_batch<7>& batch)
+	{
+		errors += batch.size() > 12;
+		for (std::size_t i = 0; i < batch.size(); ++i, ++next)
+			errors += batch.field(i, 0) != inplace_string<7>("S" + std::to_string(next)) || batch.field(i, 1) != inplace_string<7>(std::to_string(next * 3));
+	});
+	EXPECT_EQ(0, errors);
+	EXPECT_EQ(1000, records);
+
+	options.fields = {{10, 8}};
+	EXPECT_THROW(ingest_file<7>(tmp, options, [](const record_batch<7>&) {}), std::invalid_argument);
+
+	std::remove(tmp.c_str());
+	EXPECT_THROW(ingest_file<7>(tmp, options, [](const record_batch<7>&) {}), std::runtime_error);
+}
+
+TEST(inplace_string_serialize, compact)
+{
+	std::vector<inplace_string<15>> strings = {"", "A", "MSFT", "BERKSHIRE CLASS"};
+	std::vector<char> buffer(max_compact_size<inplace_string<15>>(strings.size()));
+	EXPECT_EQ(64, buffer.size());
+
+	char* end = encode_compact(strings.data(), strings.data() + strings.size(), buffer.data());
+	EXPECT_EQ(4 + 0 + 1 + 4 + 15, end - buffer.data());
+	EXPECT_EQ(std::string("\x04MSFT", 5), std::string(buffer.data() + 3, 5));
+
+	std::vector<inplace_string<15>> decoded(strings.size(), "garbage");
+	EXPECT_EQ(end, decode_compact(buffer.data(), end, decoded.data(), decoded.size()));
+	EXPECT_EQ(strings, decoded);
+	for (const auto& str : decoded)
+		EXPECT_TRUE(is_well_formed(str));
+
+	// one string at a time
+	inplace_string<15> str;
+	char* p = encode_compact(strings[2], buffer.data());
+	EXPECT_EQ(compact_size(strings[2]), p - buffer.data());
+	EXPECT_EQ(p, decode_compact(buffer.data(), p, str));
+	EXPECT_EQ("MSFT", str);
+
+	// truncated input, size above N, empty input
+	EXPECT_EQ(nullptr, decode_compact(buffer.data(), end - 1, decoded.data(), decoded.size()));
+	buffer[0] = 16;
+	EXPECT_EQ(nullptr, decode_compact(buffer.data(), buffer.data() + buffer.size(), str));
+	EXPECT_EQ(nullptr, decode_compact(buffer.data(), buffer.data(), str));
+	EXPECT_EQ("MSFT", str);
+}
+
+TEST(inplace_string_serialize, compact_varint)
+{
+	// sizes of 128 characters and beyond take a 2-byte varint
+	const inplace_string<200> short_str("abc");
+	const inplace_string<200> long_str(std::string(150, 'x'));
+	EXPECT_EQ(4, compact_size(short_str));
+	EXPECT_EQ(152, compact_size(long_str));
+
+	std::vector<char> buffer(max_compact_size<inplace_string<200>>(2));
+	const inplace_string<200> strings[] = {long_str, short_str};
+	char* end = encode_compact(std::begin(strings), std::end(strings), buffer.data());
+	EXPECT_EQ(156, end - buffer.data());
+	EXPECT_EQ(static_cast<char>(0x96), buffer[0]);
+	EXPECT_EQ(1, buffer[1]);
+
+	inplace_string<200> decoded[2];
+	EXPECT_EQ(end, decode_compact(buffer.data(), end, decoded, 2));
+	EXPECT_EQ(long_str, decoded[0]);
+	EXPECT_EQ(short_str, decoded[1]);
+
+	// varint longer than needed for N
+	const char overlong[] = {'\x83', '\x80', '\x00', 'a', 'b', 'c'};
+	EXPECT_EQ(nullptr, decode_compact(overlong, overlong + sizeof(overlong), decoded[0]));
+}
+
+namespace
+{
+
+struct serialized_order
+{
+	inplace_string<15> symbol;
+	std::uint64_t quantity;
+	inplace_string<7> account;
+};
+
+}
+
+TEST(inplace_string_serialize, fixed)
+{
+	std::vector<inplace_string<7>> strings = {"", "AAPL", "ABCDEFG"};
+	std::vector<char> buffer(strings.size() * sizeof(inplace_string<7>));
+	char* end = encode_fixed(strings.data(), strings.size(), buffer.data());
+	EXPECT_EQ(buffer.data() + buffer.size(), end);
+
+	std::vector<inplace_string<7>> decoded(strings.size());
+	EXPECT_EQ(end, decode_fixed(buffer.data(), end, decoded.data(), decoded.size()));
+	EXPECT_EQ(strings, decoded);
+	EXPECT_EQ(nullptr, decode_fixed(buffer.data(), end - 1, decoded.data(), decoded.size()));
+
+	// size above N, characters left after the terminator
+	buffer[sizeof(inplace_string<7>) + 7] = 8;
+	EXPECT_EQ(nullptr, decode_fixed(buffer.data(), end, decoded.data(), decoded.size()));
+	buffer[sizeof(inplace_string<7>) + 7] = 4;
+	EXPECT_EQ(nullptr, decode_fixed(buffer.data(), end, decoded.data(), decoded.size()));
+	buffer[sizeof(inplace_string<7>) + 7] = 3;
+	EXPECT_EQ(end, decode_fixed(buffer.data(), end, decoded.data(), decoded.size()));
+	buffer[sizeof(inplace_string<7>) + 5] = 'X';
+	EXPECT_EQ(nullptr, decode_fixed(buffer.data(), end, decoded.data(), decoded.size()));
+
+	// structs holding strings
+	const serialized_order orders[] = {{inplace_string<15>("IBM"), 100, inplace_string<7>("ACC1")}, {inplace_string<15>("GOOG"), 5, inplace_string<7>("ACC22")}};
+	std::vector<char> order_buffer(sizeof(orders));
+	end = encode_fixed(orders, 2, order_buffer.data());
+
+	serialized_order decoded_orders[2];
+	auto valid = [](const serialized_order& o) { return is_well_formed(o.symbol) && is_well_formed(o.account); };
+	EXPECT_EQ(end, decode_fixed(order_buffer.data(), end, decoded_orders, 2, valid));
+	EXPECT_EQ("GOOG", decoded_orders[1].symbol);
+	EXPECT_EQ(5, decoded_orders[1].quantity);
+	EXPECT_EQ("ACC22", decoded_orders[1].account);
+
+	order_buffer[sizeof(serialized_order) + offsetof(serialized_order, account) + 7] = 9;
+	EXPECT_EQ(nullptr, decode_fixed(order_buffer.data(), end, decoded_orders, 2, valid));
+}
+
+TEST(inplace_string_utf8, validation)
+{
+	EXPECT_TRUE(is_valid_utf8(inplace_string<31>("")));
+	EXPECT_TRUE(is_valid_utf8(inplace_string<31>("plain ASCII")));
+	EXPECT_TRUE(is_valid_utf8(inplace_string<31>("Z\xC3\xBCrich \xE2\x82\xAC \xF0\x9F\x98\x80")));
+
+	const char* invalid[] = {
+		"\x80",             // lone continuation
+		"\xC3",             // incomplete 2-byte sequence
+		"\xC3\x28",         // 2-byte lead followed by ASCII
+		"\xC0\xAF",         // overlong '/'
+		"\xE0\x80\xAF",     // overlong 3-byte
+		"\xF0\x80\x80\xAF", // overlong 4-byte
+		"\xED\xA0\x80",     // surrogate U+D800
+		"\xF4\x90\x80\x80", // above U+10FFFF
+		"\xF8\x88\x80\x80", // 5-byte lead
+		"\xE2\x82",         // incomplete 3-byte sequence
+		"\xFF"};
+	for (const char* s : invalid)
+	{
+		EXPECT_FALSE(is_valid_utf8(s, std::strlen(s))) << s;
+
+		// at every offset of a longer buffer, across block boundaries
+		for (std::size_t offset = 0; offset < 70; ++offset)
+		{
+			std::string str(offset, 'a');
+			str += s;
+			str += std::string(offset % 7, 'b');
+			EXPECT_FALSE(is_valid_utf8(str.data(), str.size())) << offset;
+		}
+	}
+
+	// random sequences of valid and invalid code points, compared with a sequence-by-sequence decoder
+	auto reference = [](const std::string& s)
+	{
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(s.data());
+		const unsigned char* end = p + s.size();
+		std::uint32_t cp;
+		while (p != end)
+			if ((p = detail::decode_utf8(p, end, cp)) == nullptr)
+				return false;
+		return true;
+	};
+	const char* pieces[] = {"a", "bcdefghijklmno", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xF4\x8F\xBF\xBF", "\xEF\xBF\xBF", "\x80", "\xC2", "\xE0\xA0", "\xF4\x90"};
+	std::mt19937 random(42);
+	std::size_t valid = 0;
+	for (int i = 0; i < 3000; ++i)
+	{
+		std::string str;
+		const std::size_t count = random() % 40;
+		for (std::size_t j = 0; j < count; ++j)
+			str += pieces[random() % (random() % 4 == 0 ? 11 : 7)];
+		valid += reference(str);
+		EXPECT_EQ(reference(str), is_valid_utf8(str.data(), str.size())) << str;
+	}
+	EXPECT_LT(100, valid);
+}
+
+TEST(inplace_string_utf8, code_points)
+{
+	EXPECT_EQ(0, count_code_points(inplace_string<15>()));
+	EXPECT_EQ(12, count_code_points(inplace_string<31>("Z\xC3\xBCrich \xE2\x82\xAC \xF0\x9F\x98\x80 !")));
+
+	std::string str;
+	for (int i = 0; i < 1000; ++i)
+		str += "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+	EXPECT_EQ(4000, count_code_points(str.data(), str.size()));
+}
+
+TEST(inplace_string_utf8, truncation)
+{
+	const std::string euros = "\xE2\x82\xAC\xE2\x82\xAC\xE2\x82\xAC"; // 3 bytes each
+	EXPECT_EQ(6, utf8_prefix_size(euros.data(), euros.size(), 7));
+	EXPECT_EQ(6, utf8_prefix_size(euros.data(), euros.size(), 6));
+	EXPECT_EQ(3, utf8_prefix_size(euros.data(), euros.size(), 5));
+	EXPECT_EQ(9, utf8_prefix_size(euros.data(), euros.size(), 9));
+
+	inplace_string<7> str;
+	EXPECT_EQ(utf_status::truncated, assign_utf8(str, euros));
+	EXPECT_EQ(inplace_string<7>("\xE2\x82\xAC\xE2\x82\xAC"), str);
+	EXPECT_EQ(utf_status::ok, assign_utf8(str, "abc"));
+	EXPECT_EQ("abc", str);
+	EXPECT_EQ(utf_status::truncated, assign_utf8(str, std::string("abcdef\xF0\x9F\x98\x80")));
+	EXPECT_EQ("abcdef", str);
+
+	// the prefix kept is checked, str is untouched when invalid
+	EXPECT_EQ(utf_status::invalid, assign_utf8(str, "ab\xC0\xAF"));
+	EXPECT_EQ("abcdef", str);
+	EXPECT_EQ(utf_status::truncated, assign_utf8(str, "abcdefg\xFF"));
+	EXPECT_EQ("abcdefg", str);
+}
+
+TEST(inplace_string_utf8, transcode)
+{
+	const inplace_string<31> utf8("Z\xC3\xBCrich \xE2\x82\xAC \xF0\x9F\x98\x80");
+	inplace_u16string<31> utf16;
+	inplace_u32string<31> utf32;
+
+	EXPECT_EQ(utf_status::ok, transcode(utf8, utf16));
+	EXPECT_EQ(inplace_u16string<31>(u"Z\u00FCrich \u20AC \U0001F600"), utf16);
+	EXPECT_EQ(utf_status::ok, transcode(utf8, utf32));
+	EXPECT_EQ(inplace_u32string<31>(U"Z\u00FCrich \u20AC \U0001F600"), utf32);
+
+	inplace_string<31> back;
+	EXPECT_EQ(utf_status::ok, transcode(utf16, back));
+	EXPECT_EQ(utf8, back);
+	back.clear();
+	EXPECT_EQ(utf_status::ok, transcode(utf32, back));
+	EXPECT_EQ(utf8, back);
+	EXPECT_EQ(utf_status::ok, transcode(utf32, utf16));
+	EXPECT_EQ(inplace_u16string<31>(u"Z\u00FCrich \u20AC \U0001F600"), utf16);
+
+	// long ASCII runs, copied by blocks
+	const inplace_string<63> ascii("The quick brown fox jumps over the lazy dog, twice: the quick!");
+	inplace_u32string<63> ascii32;
+	EXPECT_EQ(utf_status::ok, transcode(ascii, ascii32));
+	EXPECT_EQ(inplace_u32string<63>(U"The quick brown fox jumps over the lazy dog, twice: the quick!"), ascii32);
+	inplace_u16string<20> ascii16;
+	EXPECT_EQ(utf_status::truncated, transcode(ascii, ascii16));
+	EXPECT_EQ(inplace_u16string<20>(u"The quick brown fox "), ascii16);
+
+	// cut before a sequence or a surrogate pair that does not fit
+	inplace_string<8> small;
+	EXPECT_EQ(utf_status::truncated, transcode(utf16, small));
+	EXPECT_EQ(inplace_string<8>("Z\xC3\xBCrich "), small);
+	inplace_u16string<10> small16;
+	EXPECT_EQ(utf_status::truncated, transcode(utf32, small16));
+	EXPECT_EQ(inplace_u16string<10>(u"Z\u00FCrich \u20AC "), small16);
+
+	// invalid input leaves the destination untouched
+	const char16_t lone[] = {u'a', 0xD800, u'b'};
+	EXPECT_EQ(utf_status::invalid, transcode(inplace_u16string<7>(lone, 3), back));
+	EXPECT_EQ(utf8, back);
+	EXPECT_EQ(utf_status::invalid, transcode(inplace_string<7>("a\xE2\x82"), utf32));
+	const char32_t large[] = {0x10FFFF, 0x110000};
+	EXPECT_EQ(utf_status::invalid, transcode(inplace_u32string<3>(large, 2), back));
+	EXPECT_EQ(utf8, back);
+}